@@ -0,0 +1,345 @@
+#ifndef BLOCK_KERNELS_HPP_INCLUDED
+#define BLOCK_KERNELS_HPP_INCLUDED
+
+#include <complex>
+#include <memory/arena.hpp>
+#include <memory/alignment.hpp>
+#include <sdk/simd.hpp>
+
+/**
+ * vectorized kernels over the blocks operator * returns
+ *
+ * all pointers have to be aligned like the blocks of the iterators (to
+ * REMOTEBUFF_ARENA_ALIGNMENT), in and out may be the same block; whole
+ * vectors are processed at the widest width the CPU supports (see
+ * ext::simd_dispatch) and the rest of a partial block element by element
+ *
+ *   T * x = *it_x;                          // remote_block_input_iterator
+ *   T * y = *it_y;                                // remote_block_iterator
+ *   ext::axpy(a, x, y, it_y.count());
+ *
+ * the unary ones come as block kernels for stream_transform as well:
+ *
+ *   stream_transform(in, out, ext::scaling<float>(2), 4096);
+ *
+ */
+
+namespace ext
+{
+
+  template<typename T>
+  struct axpy_kernel
+  {
+    T a;
+    const T * x;
+    T * y;
+    int count;
+
+    template<int Bytes>
+    REMOTEBUFF_ALWAYS_INLINE void run() const
+    {
+      typedef typename simd<T, Bytes>::type vec;
+      enum { lanes = simd<T, Bytes>::lanes };
+      const T * in = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(x);
+      T * out = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(y);
+      vec va = a - (vec){};                                       // broadcast a
+      int i = 0;
+      for(; i + lanes <= count; i += lanes)
+      {
+        *(vec*)(out + i) = va * *(const vec*)(in + i) + *(const vec*)(out + i);
+      }
+      for(; i<count; i++)
+      {
+        out[i] = a * in[i] + out[i];
+      }
+    }
+  };
+
+  template<typename T>
+  struct scale_kernel
+  {
+    T a;
+    const T * x;
+    T * y;
+    int count;
+
+    template<int Bytes>
+    REMOTEBUFF_ALWAYS_INLINE void run() const
+    {
+      typedef typename simd<T, Bytes>::type vec;
+      enum { lanes = simd<T, Bytes>::lanes };
+      const T * in = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(x);
+      T * out = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(y);
+      vec va = a - (vec){};
+      int i = 0;
+      for(; i + lanes <= count; i += lanes)
+      {
+        *(vec*)(out + i) = va * *(const vec*)(in + i);
+      }
+      for(; i<count; i++)
+      {
+        out[i] = a * in[i];
+      }
+    }
+  };
+
+  template<typename T>
+  struct multiply_add_kernel
+  {
+    const T * a;
+    const T * b;
+    const T * c;
+    T * d;
+    int count;
+
+    template<int Bytes>
+    REMOTEBUFF_ALWAYS_INLINE void run() const
+    {
+      typedef typename simd<T, Bytes>::type vec;
+      enum { lanes = simd<T, Bytes>::lanes };
+      const T * x = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(a);
+      const T * y = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(b);
+      const T * z = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(c);
+      T * out = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(d);
+      int i = 0;
+      for(; i + lanes <= count; i += lanes)
+      {
+        *(vec*)(out + i) = *(const vec*)(x + i) * *(const vec*)(y + i) +
+          *(const vec*)(z + i);
+      }
+      for(; i<count; i++)
+      {
+        out[i] = x[i] * y[i] + z[i];
+      }
+    }
+  };
+
+  template<typename From, typename To>
+  struct convert_kernel
+  {
+    const From * x;
+    To * y;
+    int count;
+
+    template<int Bytes>
+    REMOTEBUFF_ALWAYS_INLINE void run() const
+    {
+      const From * in = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(x);
+      To * out = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(y);
+      int i = 0;
+#if __GNUC__ >= 9
+      enum { lanes = Bytes / (sizeof(From) > sizeof(To) ?
+        sizeof(From) : sizeof(To)) };
+      typedef typename simd<From, lanes*sizeof(From)>::type from_vec;
+      typedef typename simd<To, lanes*sizeof(To)>::type to_vec;
+      for(; i + lanes <= count; i += lanes)
+      {
+        *(to_vec*)(out + i) =
+          __builtin_convertvector(*(const from_vec*)(in + i), to_vec);
+      }
+#endif
+      for(; i<count; i++)
+      {
+        out[i] = (To) in[i];
+      }
+    }
+  };
+
+  template<typename T>
+  struct clamp_kernel
+  {
+    T lo;
+    T hi;
+    const T * x;
+    T * y;
+    int count;
+
+    template<int Bytes>
+    REMOTEBUFF_ALWAYS_INLINE void run() const
+    {
+      const T * in = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(x);
+      T * out = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(y);
+      int i = 0;
+#ifdef REMOTEBUFF_VECTOR_SELECT
+      typedef typename simd<T, Bytes>::type vec;
+      enum { lanes = simd<T, Bytes>::lanes };
+      vec vlo = lo - (vec){};
+      vec vhi = hi - (vec){};
+      for(; i + lanes <= count; i += lanes)
+      {
+        vec v = *(const vec*)(in + i);
+        v = v < vlo ? vlo : v;
+        *(vec*)(out + i) = v > vhi ? vhi : v;
+      }
+#endif
+      for(; i<count; i++)
+      {
+        T v = in[i];
+        out[i] = (v < lo) ? lo : (v > hi) ? hi : v;
+      }
+    }
+  };
+
+  /**
+   * complex numbers are interleaved (re, im), the real and imaginary parts
+   * of a are duplicated with shuffles, b is swapped pairwise:
+   * a * b = (ar, ar) * (br, bi) + (ai, ai) * (bi, br) * (-1, 1)
+   */
+  template<typename T>
+  struct complex_multiply_kernel
+  {
+    const std::complex<T> * a;
+    const std::complex<T> * b;
+    std::complex<T> * c;
+    int count;
+
+    template<int Bytes>
+    REMOTEBUFF_ALWAYS_INLINE void run() const
+    {
+      typedef typename simd<T, Bytes>::type vec;
+      typedef typename lane_index<sizeof(T)>::type index;
+      typedef index mask __attribute__((vector_size(Bytes)));
+      enum { lanes = simd<T, Bytes>::lanes };
+      const T * x = (const T*)memory::assume_aligned<
+        REMOTEBUFF_ARENA_ALIGNMENT>(a);
+      const T * y = (const T*)memory::assume_aligned<
+        REMOTEBUFF_ARENA_ALIGNMENT>(b);
+      T * z = (T*)memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(c);
+
+      union { mask v; index e[lanes]; } real, imag, swap;
+      typename simd<T, Bytes>::lanes_of sign;
+      for(int l=0; l<lanes; l++)             // constant, folded by the compiler
+      {
+        real.e[l] = l & ~1;
+        imag.e[l] = l | 1;
+        swap.e[l] = l ^ 1;
+        sign.e[l] = (l & 1) ? 1 : -1;
+      }
+
+      int i = 0;
+      for(; i + lanes <= 2*count; i += lanes)
+      {
+        vec u = *(const vec*)(x + i);
+        vec v = *(const vec*)(y + i);
+        *(vec*)(z + i) = __builtin_shuffle(u, real.v) * v +
+          __builtin_shuffle(u, imag.v) * __builtin_shuffle(v, swap.v) *
+          sign.v;
+      }
+      for(; i<2*count; i+=2)
+      {
+        T ar = x[i], ai = x[i+1], br = y[i], bi = y[i+1];
+        z[i] = ar * br - ai * bi;
+        z[i+1] = ar * bi + ai * br;
+      }
+    }
+  };
+
+  /**
+   * y = a * x + y
+   */
+  template<typename T>
+  inline void axpy(T a, const T * x, T * y, int count)
+  {
+    axpy_kernel<T> k = { a, x, y, count };
+    simd_dispatch::run(k);
+  }
+
+  /**
+   * y = a * x
+   */
+  template<typename T>
+  inline void scale(T a, const T * x, T * y, int count)
+  {
+    scale_kernel<T> k = { a, x, y, count };
+    simd_dispatch::run(k);
+  }
+
+  /**
+   * d = a * b + c, fused where the CPU has FMA
+   */
+  template<typename T>
+  inline void multiply_add(const T * a, const T * b, const T * c, T * d,
+    int count)
+  {
+    multiply_add_kernel<T> k = { a, b, c, d, count };
+    simd_dispatch::run(k);
+  }
+
+  /**
+   * y = (To) x
+   */
+  template<typename From, typename To>
+  inline void convert(const From * x, To * y, int count)
+  {
+    convert_kernel<From, To> k = { x, y, count };
+    simd_dispatch::run(k);
+  }
+
+  /**
+   * y = x limited to [lo, hi]
+   */
+  template<typename T>
+  inline void clamp(T lo, T hi, const T * x, T * y, int count)
+  {
+    clamp_kernel<T> k = { lo, hi, x, y, count };
+    simd_dispatch::run(k);
+  }
+
+  /**
+   * c = a * b for count complex numbers
+   */
+  template<typename T>
+  inline void complex_multiply(const std::complex<T> * a,
+    const std::complex<T> * b, std::complex<T> * c, int count)
+  {
+    complex_multiply_kernel<T> k = { a, b, c, count };
+    simd_dispatch::run(k);
+  }
+
+  /**
+   * @brief scale as a block kernel for stream_transform
+   */
+  template<typename T>
+  struct scaling
+  {
+    T a;
+    scaling(T a_) : a(a_) { }
+
+    inline void operator()(const T * in, T * out, int count) const
+    {
+      scale(a, in, out, count);
+    }
+  };
+
+  /**
+   * @brief clamp as a block kernel for stream_transform
+   */
+  template<typename T>
+  struct clamping
+  {
+    T lo;
+    T hi;
+    clamping(T lo_, T hi_) : lo(lo_), hi(hi_) { }
+
+    inline void operator()(const T * in, T * out, int count) const
+    {
+      clamp(lo, hi, in, out, count);
+    }
+  };
+
+  /**
+   * @brief convert as a block kernel for stream_transform
+   */
+  struct converting
+  {
+    template<typename From, typename To>
+    inline void operator()(const From * in, To * out, int count) const
+    {
+      convert(in, out, count);
+    }
+  };
+
+}
+
+
+#endif // BLOCK_KERNELS_HPP_INCLUDED
@@ -0,0 +1,328 @@
+#ifndef STREAM_REDUCE_HPP_INCLUDED
+#define STREAM_REDUCE_HPP_INCLUDED
+
+#include <assert.h>
+#include <cstddef>
+#include <stdint.h>
+#include <containers/remote.hpp>
+#include <iterators/remote_block_input_iterator.hpp>
+#include <memory/alignment.hpp>
+#include <runtime/workers.hpp>
+#include <sdk/simd.hpp>
+#include <slicers/vector_slicer.hpp>
+#include <slicers/bounded_slicer.hpp>
+
+namespace ext
+{
+
+  /**
+   * @brief sum of all elements
+   */
+  template<typename T>
+  struct sum
+  {
+    typedef T result_type;
+
+    T identity() const
+    {
+      return 0;
+    }
+
+    void block(T & acc, const T * data, int count) const
+    {
+      typedef typename simd<T>::type vec;
+      enum { lanes = simd<T>::lanes };
+      data = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(data);
+      vec a = {0}, b = {0};                    // two chains to hide the latency
+      int i = 0;
+      for(; i + 2*lanes <= count; i += 2*lanes)
+      {
+        a += *(const vec*)(data + i);
+        b += *(const vec*)(data + i + lanes);
+      }
+      typename simd<T>::lanes_of u;
+      u.v = a + b;
+      for(int l=0; l<lanes; l++)
+      {
+        acc += u.e[l];
+      }
+      for(; i<count; i++)
+      {
+        acc += data[i];
+      }
+    }
+
+    T combine(const T & a, const T & b) const
+    {
+      return a + b;
+    }
+  };
+
+  /**
+   * @brief smallest (Max false) or largest (Max true) element
+   */
+  template<typename T, bool Max>
+  struct extremum
+  {
+    typedef T result_type;
+
+    T start;
+
+    extremum(const T & start_) : start(start_) { }
+
+    T identity() const
+    {
+      return start;
+    }
+
+    void block(T & acc, const T * data, int count) const
+    {
+      data = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(data);
+      int i = 0;
+#ifdef REMOTEBUFF_VECTOR_SELECT
+      typedef typename simd<T>::type vec;
+      enum { lanes = simd<T>::lanes };
+      if(count >= lanes)
+      {
+        vec a = *(const vec*)data;
+        for(i=lanes; i + lanes <= count; i += lanes)
+        {
+          vec x = *(const vec*)(data + i);
+          a = Max ? (x > a ? x : a) : (x < a ? x : a);
+        }
+        typename simd<T>::lanes_of u;
+        u.v = a;
+        for(int l=0; l<lanes; l++)
+        {
+          acc = combine(acc, u.e[l]);
+        }
+      }
+#endif
+      for(; i<count; i++)
+      {
+        acc = combine(acc, data[i]);
+      }
+    }
+
+    T combine(const T & a, const T & b) const
+    {
+      return better(b, a) ? b : a;
+    }
+
+  private:
+
+    static bool better(const T & x, const T & y)
+    {
+      return Max ? (x > y) : (x < y);
+    }
+  };
+
+  template<typename T>
+  struct minimum : extremum<T, false>
+  {
+    minimum(const T & start) : extremum<T, false>(start) { }
+  };
+
+  template<typename T>
+  struct maximum : extremum<T, true>
+  {
+    maximum(const T & start) : extremum<T, true>(start) { }
+  };
+
+  /**
+   * @brief counts of Bins equally wide bins over [lo, hi), elements outside
+   * go to the first and the last bin
+   */
+  template<int Bins>
+  struct bins
+  {
+    uint64_t count[Bins];
+  };
+
+  template<typename T, int Bins>
+  struct histogram
+  {
+    typedef bins<Bins> result_type;
+
+    T lo;
+    double scale;                                        //!< bins per unit of T
+
+    histogram(const T & lo_, const T & hi_) :
+      lo(lo_), scale(Bins / ((double)hi_ - lo_))
+    { }
+
+    result_type identity() const
+    {
+      result_type r;
+      for(int b=0; b<Bins; b++)
+      {
+        r.count[b] = 0;
+      }
+      return r;
+    }
+
+    void block(result_type & acc, const T * data, int count) const
+    {
+      for(int i=0; i<count; i++)
+      {
+        double x = ((double)data[i] - lo) * scale;
+        int b = (x < 0) ? 0 : (x >= Bins) ? Bins-1 : (int)x;
+        acc.count[b]++;
+      }
+    }
+
+    result_type combine(const result_type & a, const result_type & b) const
+    {
+      result_type r;
+      for(int i=0; i<Bins; i++)
+      {
+        r.count[i] = a.count[i] + b.count[i];
+      }
+      return r;
+    }
+  };
+
+  /**
+   * @brief sum of the products of two blocks, the reduction of stream_dot
+   */
+  template<typename T>
+  struct dot
+  {
+    typedef T result_type;
+
+    T identity() const
+    {
+      return 0;
+    }
+
+    void block(T & acc, const T * x, const T * y, int count) const
+    {
+      typedef typename simd<T>::type vec;
+      enum { lanes = simd<T>::lanes };
+      x = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(x);
+      y = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(y);
+      vec a = {0}, b = {0};
+      int i = 0;
+      for(; i + 2*lanes <= count; i += 2*lanes)
+      {
+        a += *(const vec*)(x + i) * *(const vec*)(y + i);
+        b += *(const vec*)(x + i + lanes) * *(const vec*)(y + i + lanes);
+      }
+      typename simd<T>::lanes_of u;
+      u.v = a + b;
+      for(int l=0; l<lanes; l++)
+      {
+        acc += u.e[l];
+      }
+      for(; i<count; i++)
+      {
+        acc += x[i] * y[i];
+      }
+    }
+
+    T combine(const T & a, const T & b) const
+    {
+      return a + b;
+    }
+  };
+
+  /**
+   * true if stream_reduce and stream_dot return the result over all workers,
+   * false if every worker gets back only its own partial; the SPEs of the
+   * Cell have no runtime to combine them, the caller has to
+   */
+#ifdef REMOTEBUFF_HOST_DMA
+  static const bool partials_combined = true;
+#else
+  static const bool partials_combined = false;
+#endif
+
+  /**
+   * the partials of all workers combined with op if partials_combined, see
+   * workers::reduce, otherwise this worker's partial unchanged
+   */
+  template<typename R, typename Op>
+  inline R combine_partials(const R & partial, const Op & op)
+  {
+#ifdef REMOTEBUFF_HOST_DMA
+    return workers::reduce(partial, op);
+#else
+    (void)op;
+    return partial;
+#endif
+  }
+
+}
+
+/**
+ * stream reduce
+ *
+ * folds in block by block into a partial of this worker with
+ * op.block(partial, const T * data, int count), the blocks are distributed
+ * over the workers like vector_slicer does
+ *
+ * with the host runtime the partials of all workers are combined with
+ * op.combine in a tree and every worker returns the result:
+ *
+ *   ext::workers::run(job);             // in job():
+ *   float total = stream_reduce(in, ext::sum<float>(), 4096);
+ *
+ * on the Cell every SPE returns only its own partial, ext::partials_combined
+ * is false there and the caller combines the partials with op.combine
+ *
+ */
+template<typename T, typename Op>
+typename Op::result_type stream_reduce(const remote::vector<T> & in,
+  const Op & op, int block, uint8_t depth = 2)
+{
+  vector_slicer slicer(block);
+  uint32_t count = partial_block_count(slicer, in.size(), block);
+  bounded_slicer<vector_slicer> bounded(slicer, count);
+
+  remote_block_input_iterator<T, bounded_slicer<vector_slicer> >
+    it(depth, block, bounded);
+  it = in.begin();
+
+  typename Op::result_type partial = op.identity();
+  for(uint32_t n=0; n<count; n++, it++)
+  {
+    const T * data = *it;
+    op.block(partial, data, it.count());
+  }
+  return ext::combine_partials(partial, op);
+}
+
+/**
+ * stream dot product of x and y, distributed like stream_reduce and with the
+ * same result, the total or this worker's partial; y must hold at least as
+ * many elements as x
+ */
+template<typename T>
+T stream_dot(const remote::vector<T> & x, const remote::vector<T> & y,
+  int block, uint8_t depth = 2)
+{
+  assert(y.size() >= x.size());
+  vector_slicer slicer(block);
+  uint32_t count = partial_block_count(slicer, x.size(), block);
+  bounded_slicer<vector_slicer> bounded(slicer, count);
+
+  remote_block_input_iterator<T, bounded_slicer<vector_slicer> >
+    it_x(depth, block, bounded);
+  remote_block_input_iterator<T, bounded_slicer<vector_slicer> >
+    it_y(depth, block, bounded);
+  it_x = x.begin();
+  it_y = y.begin();
+
+  ext::dot<T> op;
+  T partial = op.identity();
+  for(uint32_t n=0; n<count; n++, it_x++, it_y++)
+  {
+    const T * a = *it_x;
+    const T * b = *it_y;
+    op.block(partial, a, b, it_x.count());
+  }
+  return ext::combine_partials(partial, op);
+}
+
+
+#endif // STREAM_REDUCE_HPP_INCLUDED
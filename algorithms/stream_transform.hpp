@@ -0,0 +1,106 @@
+#ifndef STREAM_TRANSFORM_HPP_INCLUDED
+#define STREAM_TRANSFORM_HPP_INCLUDED
+
+#include <assert.h>
+#include <containers/remote.hpp>
+#include <iterators/remote_block_input_iterator.hpp>
+#include <iterators/remote_block_output_iterator.hpp>
+#include <slicers/vector_slicer.hpp>
+#include <slicers/bounded_slicer.hpp>
+#include <slicers/dynamic_slicer.hpp>
+
+/**
+ * element wise kernel
+ *
+ * turns a function of one element (a Phoenix expression like arg1 * 2 for
+ * example) into a block kernel for stream_transform
+ *
+ */
+template<typename F>
+struct elementwise_kernel
+{
+  F f;
+
+  elementwise_kernel(const F & f_) : f(f_) { }
+
+  template<typename T, typename U>
+  inline void operator()(const T * in, U * out, int count) const
+  {
+    for(int i=0; i<count; i++)
+    {
+      out[i] = f(in[i]);
+    }
+  }
+};
+
+template<typename F>
+inline elementwise_kernel<F> elementwise(const F & f)
+{
+  return elementwise_kernel<F>(f);
+}
+
+/**
+ * stream transform
+ *
+ * streams in through kernel(const T * in, U * out, int count) into out, block
+ * elements at a time with depth buffers per stream; while block i is
+ * computed block i+1 is loaded and block i-1 is stored
+ *
+ * the blocks are distributed over the ranks like vector_slicer does; the
+ * transfers of the final block are clamped to the end of the data and the
+ * kernel gets its valid element count, so no vector needs padding; out
+ * must hold at least as many elements as in, the ones past in.size() are
+ * not written
+ *
+ */
+template<typename T, typename U, typename Kernel>
+void stream_transform(const remote::vector<T> & in, remote::vector<U> & out,
+  Kernel kernel, int block, uint8_t depth = 2)
+{
+  assert(out.size() >= in.size());
+  vector_slicer slicer(block);
+  uint32_t count = partial_block_count(slicer, in.size(), block);
+  bounded_slicer<vector_slicer> bounded(slicer, count);
+
+  remote_block_input_iterator<T, bounded_slicer<vector_slicer> >
+    it_in(depth, block, bounded);
+  remote_block_output_iterator<U, bounded_slicer<vector_slicer> >
+    it_out(depth, block, bounded);
+  it_in = in.begin();
+  it_out = out.begin(in.size());
+
+  for(uint32_t n=0; n<count; n++, it_in++, it_out++)
+  {
+    kernel((const T*)*it_in, *it_out, it_in.count());
+  }
+}
+
+/**
+ * stream transform with dynamic scheduling
+ *
+ * like above but the blocks are claimed from counter while prefetching, so
+ * ranks with cheaper blocks take more of them; all ranks pass the same
+ * counter, set up with the number of blocks of the input including a
+ * partial last one
+ *
+ */
+template<typename T, typename U, typename Kernel>
+void stream_transform(const remote::vector<T> & in, remote::vector<U> & out,
+  Kernel kernel, int block, block_counter & counter, uint8_t depth = 2)
+{
+  assert(out.size() >= in.size());
+  dynamic_slicer slicer(counter, block, depth);
+
+  remote_block_input_iterator<T, dynamic_slicer> it_in(depth, block, slicer);
+  remote_block_output_iterator<U, dynamic_slicer> it_out(depth, block, slicer);
+  it_in = in.begin();
+  it_out = out.begin(in.size());
+
+  for(uint32_t n=0; slicer(n) >= 0; n++, it_in++, it_out++)
+  {
+    kernel((const T*)*it_in, *it_out, it_in.count());
+  }
+}
+
+
+#endif // STREAM_TRANSFORM_HPP_INCLUDED
@@ -0,0 +1,395 @@
+/**
+ * streaming benchmark
+ *
+ * compares the multi-buffered block iterators against a synchronous single
+ * buffer loop (get, wait, compute, put, wait) and sweeps depth, block size,
+ * element type and compute per byte
+ *
+ * usage: stream_bench [-m in,out,inout] [-t float,double,int] [-d 2,3,4]
+ *                     [-b 1024,4096] [-r 0,1,4] [-s megabytes] [-i runs]
+ *                     [-o trace.json]
+ *
+ * columns: GB/s of the multi-buffered and the baseline loop, percentiles of
+ * the time per block over all runs and the fraction of the baseline transfer
+ * time that the multi-buffered loop hid behind compute
+ *
+ * built with -DREMOTEBUFF_STATS, -o writes the per block events of the
+ * iterators as Chrome trace JSON
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <algorithm>
+#include <vector>
+
+#include <boost/function.hpp>
+
+#include <containers/local.hpp>
+#include <containers/remote.hpp>
+#include <iterators/remote_block_input_iterator.hpp>
+#include <iterators/remote_block_output_iterator.hpp>
+#include <iterators/remote_block_iterator.hpp>
+#include <sdk/clock.hpp>
+#include <sdk/stats.hpp>
+
+using ext::clock;
+
+
+/**
+ * linear slicing of a single stream, block n starts at n*size
+ */
+struct linear_slicer
+{
+  int size;
+  linear_slicer(int size_) : size(size_) { }
+
+  int32_t operator()(uint32_t n) const
+  {
+    return n * size;
+  }
+};
+
+/**
+ * one multiply-add, |a| < 1 keeps floating point values bounded
+ */
+template<typename T>
+struct kernel
+{
+  static T step(T x) { return x * (T)0.5 + (T)0.25; }
+};
+
+/**
+ * integers wrap around in unsigned arithmetic instead of overflowing
+ */
+template<>
+struct kernel<int32_t>
+{
+  static int32_t step(int32_t x) { return (int32_t)((uint32_t)x * 3u + 1u); }
+};
+
+/**
+ * compute kernel with a configurable number of multiply-adds per element
+ */
+template<typename T>
+inline void compute(T * data, int count, int ratio)
+{
+  for(int i=0; i<count; i++)
+  {
+    T x = data[i];
+    for(int r=0; r<ratio; r++)
+    {
+      x = kernel<T>::step(x);
+    }
+    data[i] = x;
+  }
+}
+
+enum mode { MODE_IN, MODE_OUT, MODE_INOUT };
+
+struct config
+{
+  mode m;
+  int depth;
+  int block;                                         //!< elements per block
+  int ratio;                                 //!< multiply-adds per element
+  std::size_t bytes;                                  //!< bytes per stream
+  int runs;
+};
+
+struct result
+{
+  double gbs;                                        //!< multi-buffered GB/s
+  double base_gbs;                                   //!< single buffer GB/s
+  double p50, p90, p99;                  //!< time per block in microseconds
+  double hidden;                         //!< fraction of transfer time hidden
+};
+
+static volatile double sink;
+
+/**
+ * synchronous single buffer loop, returns seconds and the time spent waiting
+ * for transfers
+ */
+template<typename T>
+double run_baseline(const config & c, remote::vector<T> & src,
+  remote::vector<T> & dst, int blocks, double & wait)
+{
+  int size = c.block * sizeof(T);
+  local::vector<T> buffer(c.block);
+  addr64 s = src.begin().address();
+  addr64 d = dst.begin().address();
+  wait = 0;
+  double acc = 0;
+
+  clock::ticks start = clock::now();
+  for(int n=0; n<blocks; n++)
+  {
+    if(c.m == MODE_OUT)                // the same work as the buffered out loop
+    {
+      memset(&buffer[0], 0, size);
+    }
+    clock::ticks t0 = clock::now();
+    if(c.m != MODE_OUT)
+    {
+      spe_ppe_get_async_c(&buffer[0], s + (uint64_t)n*size, size, 1);
+      dma_synchronize_c(1);
+    }
+    wait += clock::seconds(clock::now() - t0);
+
+    compute(&buffer[0], c.block, c.ratio);
+    acc += buffer[0];
+
+    t0 = clock::now();
+    if(c.m != MODE_IN)
+    {
+      spe_ppe_put_async_c(d + (uint64_t)n*size, &buffer[0], size, 1);
+      dma_synchronize_c(1);
+    }
+    wait += clock::seconds(clock::now() - t0);
+  }
+  sink = acc;
+  return clock::seconds(clock::now() - start);
+}
+
+/**
+ * multi-buffered loop, returns seconds, the time stalled in operator* and
+ * appends the time of every block to latency
+ */
+template<typename T>
+double run_buffered(const config & c, remote::vector<T> & src,
+  remote::vector<T> & dst, int blocks, double & stall,
+  std::vector<double> & latency)
+{
+  linear_slicer slicer(c.block);
+  stall = 0;
+  double acc = 0;
+
+  clock::ticks start = clock::now();
+  if(c.m == MODE_IN)
+  {
+    remote_block_input_iterator<T, linear_slicer> it(c.depth, c.block,
+      slicer);
+    it = src.begin();
+    for(int n=0; n<blocks; n++, it++)
+    {
+      clock::ticks t0 = clock::now();
+      T * data = *it;
+      clock::ticks t1 = clock::now();
+      compute(data, c.block, c.ratio);
+      acc += data[0];
+      stall += clock::seconds(t1 - t0);
+      latency.push_back(clock::seconds(clock::now() - t0) * 1e6);
+    }
+  }
+  else if(c.m == MODE_OUT)
+  {
+    clock::ticks t0 = clock::now();
+    {
+      remote_block_output_iterator<T, linear_slicer> it(c.depth, c.block,
+        slicer);
+      it = dst.begin();
+      for(int n=0; n<blocks; n++, it++)
+      {
+        t0 = clock::now();
+        T * data = *it;
+        clock::ticks t1 = clock::now();
+        memset(data, 0, c.block*sizeof(T));
+        compute(data, c.block, c.ratio);
+        stall += clock::seconds(t1 - t0);
+        latency.push_back(clock::seconds(clock::now() - t0) * 1e6);
+      }
+      t0 = clock::now();
+    }                                    // the destructor drains the stores
+    stall += clock::seconds(clock::now() - t0);
+  }
+  else
+  {
+    clock::ticks t0 = clock::now();
+    {
+      remote_block_iterator<T, linear_slicer> it(c.depth, c.block, slicer);
+      it = src.begin();
+      for(int n=0; n<blocks; n++, it++)
+      {
+        t0 = clock::now();
+        T * data = *it;
+        clock::ticks t1 = clock::now();
+        compute(data, c.block, c.ratio);
+        acc += data[0];
+        stall += clock::seconds(t1 - t0);
+        latency.push_back(clock::seconds(clock::now() - t0) * 1e6);
+      }
+      t0 = clock::now();
+    }
+    stall += clock::seconds(clock::now() - t0);
+  }
+  sink = acc;
+  return clock::seconds(clock::now() - start);
+}
+
+template<typename T>
+result run(const config & c)
+{
+  int blocks = c.bytes / (c.block * sizeof(T));
+  std::size_t length = (std::size_t)blocks * c.block;
+  local::vector<T> vsrc(length, (T)1);
+  local::vector<T> vdst(length, (T)0);
+  remote::vector<T> src = vsrc;
+  remote::vector<T> dst = vdst;
+
+  double moved = (double)blocks * c.block * sizeof(T) *
+    ((c.m == MODE_INOUT) ? 2 : 1);
+  double best = 1e30, best_base = 1e30, stall = 0, wait = 0;
+  std::vector<double> latency;
+  latency.reserve((std::size_t)blocks * c.runs);
+
+  for(int r=0; r<c.runs; r++)
+  {
+    double w = 0, s = 0;
+    std::fill(vsrc.begin(), vsrc.end(), (T)1);       // inout computes in place
+    best_base = std::min(best_base, run_baseline(c, src, dst, blocks, w));
+    wait += w;
+    std::fill(vsrc.begin(), vsrc.end(), (T)1);
+    best = std::min(best, run_buffered(c, src, dst, blocks, s, latency));
+    stall += s;
+  }
+
+  std::sort(latency.begin(), latency.end());
+  result res;
+  res.gbs = moved / best * 1e-9;
+  res.base_gbs = moved / best_base * 1e-9;
+  std::size_t samples = latency.size();
+  res.p50 = samples ? latency[samples / 2] : 0;        // no block fits the data
+  res.p90 = samples ? latency[(samples * 9) / 10] : 0;
+  res.p99 = samples ? latency[(samples * 99) / 100] : 0;
+  res.hidden = (wait > 0) ? 1.0 - stall / wait : 0;
+  res.hidden = std::max(0.0, std::min(1.0, res.hidden));
+  return res;
+}
+
+/**
+ * parse a comma separated list of integers
+ */
+static std::vector<int> parse_list(const char * s)
+{
+  std::vector<int> v;
+  while(*s)
+  {
+    v.push_back(atoi(s));
+    while(*s && *s != ',') s++;
+    if(*s) s++;
+  }
+  return v;
+}
+
+/**
+ * check if word is an entry of a comma separated list
+ */
+static bool has(const char * list, const char * word)
+{
+  std::size_t len = strlen(word);
+  while(*list)
+  {
+    if(!strncmp(list, word, len) && (list[len] == ',' || list[len] == 0))
+    {
+      return true;
+    }
+    while(*list && *list != ',') list++;
+    if(*list) list++;
+  }
+  return false;
+}
+
+int main(int argc, char ** argv)
+{
+  const char * modes = "in,out,inout";
+  const char * types = "float,double,int";
+  std::vector<int> depths = parse_list("2,3,4");
+  std::vector<int> blocks = parse_list("1024,4096,16384");
+  std::vector<int> ratios = parse_list("0,1,4,16");
+  std::size_t megabytes = 32;
+  int runs = 3;
+  const char * trace_path = 0;
+
+  int opt;
+  while((opt = getopt(argc, argv, "m:t:d:b:r:s:i:o:")) != -1)
+  {
+    switch(opt)
+    {
+      case 'm': modes = optarg; break;
+      case 't': types = optarg; break;
+      case 'd': depths = parse_list(optarg); break;
+      case 'b': blocks = parse_list(optarg); break;
+      case 'r': ratios = parse_list(optarg); break;
+      case 's': megabytes = atoi(optarg); break;
+      case 'i': runs = atoi(optarg); break;
+      case 'o': trace_path = optarg; break;
+      default:
+        fprintf(stderr, "usage: %s [-m in,out,inout] [-t float,double,int] "
+          "[-d depths] [-b blocks] [-r ratios] [-s MB] [-i runs] "
+          "[-o trace.json]\n", argv[0]);
+        return 1;
+    }
+  }
+
+  printf("%-6s %-6s %5s %7s %5s %8s %8s %9s %9s %9s %7s\n", "mode", "type",
+    "depth", "block", "ratio", "GB/s", "base", "p50[us]", "p90[us]",
+    "p99[us]", "hidden");
+
+  const char * mode_names[] = { "in", "out", "inout" };
+  const char * type_names[] = { "float", "double", "int" };
+  for(int m=0; m<3; m++)
+  {
+    if(!has(modes, mode_names[m]))
+    {
+      continue;
+    }
+    for(int t=0; t<3; t++)
+    {
+      if(!has(types, type_names[t]))
+      {
+        continue;
+      }
+      for(std::size_t d=0; d<depths.size(); d++)
+      for(std::size_t b=0; b<blocks.size(); b++)
+      for(std::size_t r=0; r<ratios.size(); r++)
+      {
+        config c;
+        c.m = (mode)m;
+        c.depth = depths[d];
+        c.block = blocks[b];
+        c.ratio = ratios[r];
+        c.bytes = megabytes << 20;
+        c.runs = runs;
+
+        result res;
+        switch(t)
+        {
+          case 0: res = run<float>(c); break;
+          case 1: res = run<double>(c); break;
+          default: res = run<int32_t>(c); break;
+        }
+        printf("%-6s %-6s %5d %7d %5d %8.2f %8.2f %9.1f %9.1f %9.1f %6.1f%%\n",
+          mode_names[m], type_names[t], c.depth, c.block, c.ratio, res.gbs,
+          res.base_gbs, res.p50, res.p90, res.p99, res.hidden * 100);
+        fflush(stdout);
+      }
+    }
+  }
+
+  if(trace_path)
+  {
+#ifdef REMOTEBUFF_STATS
+    if(!ext::trace::write(trace_path))
+    {
+      fprintf(stderr, "could not write %s\n", trace_path);
+      return 1;
+    }
+#else
+    fprintf(stderr, "-o needs a build with -DREMOTEBUFF_STATS\n");
+#endif
+  }
+  return 0;
+}
@@ -0,0 +1,260 @@
+#ifndef CACHED_HPP_INCLUDED
+#define CACHED_HPP_INCLUDED
+
+#include <assert.h>
+#include <cstddef>
+#include <stdint.h>
+#include <containers/remote.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+
+#ifndef REMOTEBUFF_CACHE_TAGS
+  #define REMOTEBUFF_CACHE_TAGS 4               //!< DMA tags of a cached vector
+#endif
+
+/**
+ * software cache over a remote vector for random access
+ *
+ * the remote data is split into lines of line elements, a line is held in
+ * one of Ways slots of set (line % sets) and the least recently used slot of
+ * the set is evicted; dirty lines are written back with a put before the
+ * slot is reused, on flush and on destruction
+ *
+ *   cached::vector<float> table(remote_table, 64, 256);
+ *   table.prefetch(i + 1024);                   // optional hint
+ *   float y = table[i];
+ *   table.write(j) = y;
+ *
+ * references stay valid until the next access that misses, transfers are
+ * clamped to the end of the data like the block iterators do
+ *
+ * a line has to be a multiple of 16 bytes, of 128 bytes on the Cell; dirty
+ * lines are written back whole, so workers that write through caches of the
+ * same data must own disjoint lines, or they overwrite each other's elements
+ *
+ */
+struct cached
+{
+  template<class T, int Ways = 4>
+  class vector
+  {
+
+  private: // __________________________________________________________________
+
+    struct entry
+    {
+      uint32_t line;                     //!< line held, ~0 if the slot is empty
+      uint32_t used;                                //!< time of the last access
+      bool dirty;                                  //!< written since it was got
+      bool pending;                            //!< the get may still be running
+    };
+
+    addr64 base_address;                 //!< base address of the data we access
+    uint64_t limit;                                         //!< end of the data
+    std::size_t size_;                                   //!< number of elements
+    int sets;
+    int line;                                      //!< number of Ts in one line
+    int bytes;                                  //!< number of bytes in one line
+    std::size_t stride;                           //!< aligned bytes of one slot
+
+    char * lines;                                //!< slots, leased as one block
+    entry * entries;
+    int tags[REMOTEBUFF_CACHE_TAGS];        //!< tags for the transfers, by slot
+    uint32_t owned;                             //!< tags reserved from dma_tags
+    uint32_t time;                                   //!< access counter for LRU
+    int last;                          //!< slot of the last access, tried first
+
+    vector(const vector &);                                      // not copyable
+    vector & operator=(const vector &);
+
+  public: // ___________________________________________________________________
+
+    /**
+     * ctor, sets * Ways lines of line elements are kept in local memory
+     */
+    vector(const remote::vector<T> & data, int sets_, int line_,
+      int * _tags = 0) :
+      size_(data.size()), sets(sets_), line(line_), bytes(line_*sizeof(T)),
+      time(0), last(0)
+    {
+#ifdef CBE_MPI_CELL_SPE_SUPPORT
+      assert(bytes % 128 == 0);                   // lines are whole cache lines
+#else
+      assert(bytes % 16 == 0);                     // DMA sizes are in quadwords
+#endif
+      remote_block_base_iterator<T> it = data.begin();
+      base_address.ull = it.address().ull;
+      limit = it.limit();
+      stride = memory::arena::align(bytes);
+      lines = (char*)memory::arena::lease(stride * sets * Ways);
+      entries = (entry*)memory::arena::lease(sizeof(entry) * sets * Ways);
+      for(int i=0; i<sets*Ways; i++)
+      {
+        entries[i].line = ~0u;
+        entries[i].used = 0;
+        entries[i].dirty = false;
+        entries[i].pending = false;
+      }
+      owned = ext::dma_tags::acquire(tags, REMOTEBUFF_CACHE_TAGS, _tags);
+    }
+
+    ~vector()
+    {
+      flush();
+      ext::dma_tags::release(owned);
+      memory::arena::release(entries, sizeof(entry) * sets * Ways);
+      memory::arena::release(lines, stride * sets * Ways);
+    }
+
+    std::size_t size() const { return size_; }
+
+    /**
+     * element i for reading
+     */
+    inline const T & operator[](std::size_t i)
+    {
+      return element(i);
+    }
+
+    /**
+     * element i for writing, its line is written back when it is evicted
+     */
+    inline T & write(std::size_t i)
+    {
+      T & e = element(i);
+      entries[last].dirty = true;
+      return e;
+    }
+
+    /**
+     * start the get of the line of element i without waiting for it
+     */
+    void prefetch(std::size_t i)
+    {
+      uint32_t l = i / line;
+      if(find(l) < 0)
+      {
+        load(l);
+      }
+    }
+
+    /**
+     * write back all dirty lines and wait for all transfers
+     */
+    void flush()
+    {
+      for(int s=0; s<sets*Ways; s++)
+      {
+        if(entries[s].dirty)
+        {
+          store(s);
+        }
+      }
+      ext::dma_tags::wait(tags, REMOTEBUFF_CACHE_TAGS);
+      for(int s=0; s<sets*Ways; s++)
+      {
+        entries[s].pending = false;
+      }
+    }
+
+  private:
+
+    inline T & element(std::size_t i)
+    {
+      uint32_t l = i / line;
+      if(entries[last].line != l)                 // not the line of last access
+      {
+        last = find(l);
+        if(last < 0)
+        {
+          last = load(l);
+        }
+      }
+      entry & e = entries[last];
+      e.used = ++time;
+      if(e.pending)
+      {
+        dma_synchronize_c(tags[last % REMOTEBUFF_CACHE_TAGS]);
+        e.pending = false;
+      }
+      return ((T*)(lines + last*stride))[i - (std::size_t)l*line];
+    }
+
+    /**
+     * slot that holds line l or -1
+     */
+    int find(uint32_t l) const
+    {
+      int first = (l % sets) * Ways;
+      for(int s=first; s<first+Ways; s++)
+      {
+        if(entries[s].line == l)
+        {
+          return s;
+        }
+      }
+      return -1;
+    }
+
+    /**
+     * evict the least recently used slot of the set of line l and start the
+     * get of l into it
+     */
+    int load(uint32_t l)
+    {
+      int first = (l % sets) * Ways;
+      int victim = first;
+      for(int s=first+1; s<first+Ways; s++)
+      {
+        if(entries[s].used < entries[victim].used)
+        {
+          victim = s;
+        }
+      }
+      entry & e = entries[victim];
+      int tag = tags[victim % REMOTEBUFF_CACHE_TAGS];
+      bool busy = e.dirty || e.pending;
+      if(e.dirty)
+      {
+        store(victim);
+      }
+      if(busy)                     // the get must not overtake the put or a get
+      {
+        dma_synchronize_c(tag);
+      }
+      e.line = l;
+      e.used = time;
+      e.dirty = false;
+      e.pending = true;
+      spe_ppe_get_tail_async_c(lines + victim*stride,
+        base_address+(uint64_t)l*bytes, clamp(l), tag);
+      return victim;
+    }
+
+    void store(int s)
+    {
+      spe_ppe_put_tail_async_c(base_address+(uint64_t)entries[s].line*bytes,
+        lines + s*stride, clamp(entries[s].line),
+        tags[s % REMOTEBUFF_CACHE_TAGS]);
+      entries[s].dirty = false;
+    }
+
+    /**
+     * bytes of line l that lie before the end of the data
+     */
+    int clamp(uint32_t l) const
+    {
+      uint64_t at = base_address.ull + (uint64_t)l*bytes;
+      if(at >= limit)
+      {
+        return 0;
+      }
+      return (limit - at < (uint64_t)bytes) ? limit - at : bytes;
+    }
+
+  };
+};
+
+
+#endif // CACHED_HPP_INCLUDED
@@ -0,0 +1,119 @@
+#ifndef DISK_HPP_INCLUDED
+#define DISK_HPP_INCLUDED
+
+#include <cstddef>
+#include <iterators/file_block_base_iterator.hpp>
+
+#ifndef __SPU__
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * file containers for the file block iterators
+ *
+ * unlike mapped::vector the data is not mapped, the file block iterators
+ * read and write it block by block with asynchronous file transfers; the
+ * file is opened twice, transfers whose buffer, offset and length are
+ * multiples of REMOTEBUFF_DIRECT_ALIGNMENT bypass the page cache through an
+ * O_DIRECT descriptor, all others use the buffered one
+ *
+ *   disk::vector<float> in("frames.raw");
+ *   file_block_input_iterator<float, vector_slicer> it(depth, size, slicer);
+ *   it = in.begin();
+ *
+ */
+struct disk
+{
+  enum access { read_only, read_write };
+
+  template<class T>
+  class vector
+  {
+
+  private: // __________________________________________________________________
+
+    int fd;
+    int direct_fd;                                //!< O_DIRECT descriptor or -1
+    std::size_t size_;                                   //!< number of elements
+
+    vector(const vector &);                                      // not copyable
+    vector & operator=(const vector &);
+
+  public: // ___________________________________________________________________
+
+    /**
+     * open an existing file
+     */
+    explicit vector(const char * path, access mode = read_only) :
+      fd(-1), direct_fd(-1), size_(0)
+    {
+      int flags = (mode == read_write) ? O_RDWR : O_RDONLY;
+      fd = open(path, flags);
+      struct stat st;
+      if(fd >= 0 && fstat(fd, &st) == 0)
+      {
+        size_ = st.st_size / sizeof(T);
+      }
+      open_direct(path, flags);
+    }
+
+    /**
+     * create (or truncate) a file of n elements
+     */
+    vector(const char * path, std::size_t n) :
+      fd(-1), direct_fd(-1), size_(0)
+    {
+      fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if(fd >= 0 && ftruncate(fd, n * sizeof(T)) == 0)
+      {
+        size_ = n;
+      }
+      open_direct(path, O_RDWR);
+    }
+
+    ~vector()
+    {
+      if(direct_fd >= 0)
+      {
+        close(direct_fd);
+      }
+      if(fd >= 0)
+      {
+        close(fd);
+      }
+    }
+
+    bool is_open() const { return fd >= 0; }
+    std::size_t size() const { return size_; }
+
+    file_block_base_iterator<T> begin() const
+    {
+      return file_block_base_iterator<T>(fd, direct_fd, 0, size_ * sizeof(T));
+    }
+
+    file_block_base_iterator<T> end() const
+    {
+      return file_block_base_iterator<T>(fd, direct_fd, size_ * sizeof(T),
+        size_ * sizeof(T));
+    }
+
+  private:
+
+    void open_direct(const char * path, int flags)
+    {
+#ifdef O_DIRECT
+      if(fd >= 0)
+      {
+        direct_fd = open(path, flags | O_DIRECT);
+      }
+#endif
+    }
+
+  };
+};
+
+#endif // __SPU__
+
+#endif // DISK_HPP_INCLUDED
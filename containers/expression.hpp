@@ -0,0 +1,293 @@
+#ifndef EXPRESSION_HPP_INCLUDED
+#define EXPRESSION_HPP_INCLUDED
+
+#include <assert.h>
+#include <containers/remote.hpp>
+#include <iterators/remote_block_input_iterator.hpp>
+#include <iterators/remote_block_output_iterator.hpp>
+#include <memory/alignment.hpp>
+#include <slicers/vector_slicer.hpp>
+#include <slicers/bounded_slicer.hpp>
+
+#ifndef REMOTEBUFF_EXPRESSION_BLOCK
+  #define REMOTEBUFF_EXPRESSION_BLOCK 4096               //!< elements per block
+#endif
+
+#ifndef REMOTEBUFF_EXPRESSION_DEPTH
+  #define REMOTEBUFF_EXPRESSION_DEPTH 2                 //!< buffers per operand
+#endif
+
+/**
+ * lazy expressions over remote vectors
+ *
+ * arithmetic on remote vectors and scalars builds an expression tree,
+ * assigning it to a remote vector evaluates it in one streamed pass: every
+ * vector operand is read through its own remote_block_input_iterator, the
+ * tree is applied element by element to the blocks and the result is
+ * written through one remote_block_output_iterator, no temporary vectors
+ * are created
+ *
+ *   remote::vector<float> x = vx, y = vy, out = vout;
+ *   out = a * x + y;
+ *
+ * the blocks are distributed over the workers like vector_slicer does, so
+ * inside ext::workers::run every worker evaluates its share; the operands
+ * have to be at least as long as the vector assigned to, which may be one
+ * of the operands, evaluate asserts it
+ *
+ */
+
+typedef bounded_slicer<vector_slicer> expression_slicer;
+
+template<typename E>
+struct expression
+{
+  const E & self() const
+  {
+    return static_cast<const E &>(*this);
+  }
+
+  template<typename T>
+  void assign_to(remote::vector<T> & out) const;
+};
+
+template<typename T>
+struct vector_operand : expression<vector_operand<T> >
+{
+  typedef T value_type;
+  remote::vector<T> v;
+
+  vector_operand(const remote::vector<T> & v_) : v(v_) { }
+};
+
+template<typename T>
+struct scalar_operand : expression<scalar_operand<T> >
+{
+  typedef T value_type;
+  T value;
+
+  scalar_operand(const T & value_) : value(value_) { }
+};
+
+template<typename Op, typename L, typename R>
+struct binary_expression : expression<binary_expression<Op, L, R> >
+{
+  typedef typename L::value_type value_type;
+  L l;
+  R r;
+
+  binary_expression(const L & l_, const R & r_) : l(l_), r(r_) { }
+};
+
+namespace ext
+{
+  struct add
+  {
+    template<typename T>
+    static inline T apply(const T & a, const T & b) { return a + b; }
+  };
+
+  struct subtract
+  {
+    template<typename T>
+    static inline T apply(const T & a, const T & b) { return a - b; }
+  };
+
+  struct multiply
+  {
+    template<typename T>
+    static inline T apply(const T & a, const T & b) { return a * b; }
+  };
+
+  struct divide
+  {
+    template<typename T>
+    static inline T apply(const T & a, const T & b) { return a / b; }
+  };
+}
+
+/**
+ * @brief evaluation state of an expression node
+ *
+ * mirrors the expression tree, vector operands own the iterator of their
+ * stream; start assigns the iterators, fetch waits for the blocks of the
+ * current iteration, [i] is element i of the result and next advances;
+ * covers(n) is true if every vector operand has at least n elements
+ */
+template<typename E>
+struct expression_evaluator;
+
+template<typename T>
+struct expression_evaluator<vector_operand<T> >
+{
+  remote::vector<T> v;
+  remote_block_input_iterator<T, expression_slicer> it;
+  const T * data;
+
+  expression_evaluator(const vector_operand<T> & e, uint8_t depth, int block,
+    const expression_slicer & slicer) :
+    v(e.v), it(depth, block, slicer), data(0)
+  { }
+
+  bool covers(std::size_t n) const { return v.size() >= n; }
+  void start() { it = v.begin(); }
+  void fetch()
+  {
+    data = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(*it);
+  }
+  inline T operator[](int i) const { return data[i]; }
+  void next() { it++; }
+};
+
+template<typename T>
+struct expression_evaluator<scalar_operand<T> >
+{
+  T value;
+
+  expression_evaluator(const scalar_operand<T> & e, uint8_t, int,
+    const expression_slicer &) : value(e.value)
+  { }
+
+  bool covers(std::size_t) const { return true; }
+  void start() { }
+  void fetch() { }
+  inline T operator[](int) const { return value; }
+  void next() { }
+};
+
+template<typename Op, typename L, typename R>
+struct expression_evaluator<binary_expression<Op, L, R> >
+{
+  typedef typename L::value_type value_type;
+  expression_evaluator<L> l;
+  expression_evaluator<R> r;
+
+  expression_evaluator(const binary_expression<Op, L, R> & e, uint8_t depth,
+    int block, const expression_slicer & slicer) :
+    l(e.l, depth, block, slicer), r(e.r, depth, block, slicer)
+  { }
+
+  bool covers(std::size_t n) const { return l.covers(n) && r.covers(n); }
+  void start() { l.start(); r.start(); }
+  void fetch() { l.fetch(); r.fetch(); }
+  inline value_type operator[](int i) const
+  {
+    return Op::apply(l[i], r[i]);
+  }
+  void next() { l.next(); r.next(); }
+};
+
+/**
+ * evaluate e into out in one streamed pass, block elements at a time with
+ * depth buffers per stream
+ */
+template<typename T, typename E>
+void evaluate(remote::vector<T> & out, const expression<E> & e,
+  int block = REMOTEBUFF_EXPRESSION_BLOCK,
+  uint8_t depth = REMOTEBUFF_EXPRESSION_DEPTH)
+{
+  vector_slicer slicer(block);
+  uint32_t count = partial_block_count(slicer, out.size(), block);
+  expression_slicer bounded(slicer, count);
+
+  expression_evaluator<E> in(e.self(), depth, block, bounded);
+  assert(in.covers(out.size()));
+  remote_block_output_iterator<T, expression_slicer>
+    it_out(depth, block, bounded);
+  in.start();
+  it_out = out.begin();
+
+  for(uint32_t n=0; n<count; n++, in.next(), it_out++)
+  {
+    in.fetch();
+    T * result = memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(*it_out);
+    int valid = it_out.count();
+    for(int i=0; i<valid; i++)
+    {
+      result[i] = in[i];
+    }
+  }
+}
+
+template<typename E>
+template<typename T>
+void expression<E>::assign_to(remote::vector<T> & out) const
+{
+  evaluate(out, *this);
+}
+
+/**
+ * operator symbol for every combination of expressions, remote vectors and
+ * scalars that has at least one expression or vector
+ */
+#define REMOTEBUFF_EXPRESSION_OPERATOR(symbol, Op)                             \
+                                                                               \
+template<typename L, typename R>                                               \
+inline binary_expression<Op, L, R>                                             \
+operator symbol(const expression<L> & l, const expression<R> & r)              \
+{                                                                              \
+  return binary_expression<Op, L, R>(l.self(), r.self());                      \
+}                                                                              \
+                                                                               \
+template<typename L, typename T>                                               \
+inline binary_expression<Op, L, vector_operand<T> >                            \
+operator symbol(const expression<L> & l, const remote::vector<T> & r)          \
+{                                                                              \
+  return binary_expression<Op, L, vector_operand<T> >(l.self(), r);            \
+}                                                                              \
+                                                                               \
+template<typename T, typename R>                                               \
+inline binary_expression<Op, vector_operand<T>, R>                             \
+operator symbol(const remote::vector<T> & l, const expression<R> & r)          \
+{                                                                              \
+  return binary_expression<Op, vector_operand<T>, R>(l, r.self());             \
+}                                                                              \
+                                                                               \
+template<typename T>                                                           \
+inline binary_expression<Op, vector_operand<T>, vector_operand<T> >            \
+operator symbol(const remote::vector<T> & l, const remote::vector<T> & r)      \
+{                                                                              \
+  return binary_expression<Op, vector_operand<T>, vector_operand<T> >(l, r);   \
+}                                                                              \
+                                                                               \
+template<typename L>                                                           \
+inline binary_expression<Op, L, scalar_operand<typename L::value_type> >       \
+operator symbol(const expression<L> & l, const typename L::value_type & r)     \
+{                                                                              \
+  return binary_expression<Op, L, scalar_operand<typename L::value_type> >(    \
+    l.self(), r);                                                              \
+}                                                                              \
+                                                                               \
+template<typename R>                                                           \
+inline binary_expression<Op, scalar_operand<typename R::value_type>, R>        \
+operator symbol(const typename R::value_type & l, const expression<R> & r)     \
+{                                                                              \
+  return binary_expression<Op, scalar_operand<typename R::value_type>, R>(     \
+    l, r.self());                                                              \
+}                                                                              \
+                                                                               \
+template<typename T>                                                           \
+inline binary_expression<Op, vector_operand<T>, scalar_operand<T> >            \
+operator symbol(const remote::vector<T> & l,                                   \
+  const typename vector_operand<T>::value_type & r)                            \
+{                                                                              \
+  return binary_expression<Op, vector_operand<T>, scalar_operand<T> >(l, r);   \
+}                                                                              \
+                                                                               \
+template<typename T>                                                           \
+inline binary_expression<Op, scalar_operand<T>, vector_operand<T> >            \
+operator symbol(const typename vector_operand<T>::value_type & l,              \
+  const remote::vector<T> & r)                                                 \
+{                                                                              \
+  return binary_expression<Op, scalar_operand<T>, vector_operand<T> >(l, r);   \
+}
+
+REMOTEBUFF_EXPRESSION_OPERATOR(+, ext::add)
+REMOTEBUFF_EXPRESSION_OPERATOR(-, ext::subtract)
+REMOTEBUFF_EXPRESSION_OPERATOR(*, ext::multiply)
+REMOTEBUFF_EXPRESSION_OPERATOR(/, ext::divide)
+
+#undef REMOTEBUFF_EXPRESSION_OPERATOR
+
+
+#endif // EXPRESSION_HPP_INCLUDED
@@ -9,11 +9,20 @@
 template<typename T>
 struct make
 {
-  typedef typename local<T>::image ImageType;
+  typedef local::image<T> ImageType;
 
   static ImageType image(std::size_t dimX, std::size_t dimY)
   {
-    return ImageType(dimX * dimY);
+    return ImageType(dimX, dimY);
+  }
+
+  /**
+   * image whose elements are not initialized, to be filled by a stream
+   */
+  static ImageType image(std::size_t dimX, std::size_t dimY,
+    memory::uninitialized_t)
+  {
+    return ImageType(dimX, dimY, memory::uninitialized);
   }
 };
 
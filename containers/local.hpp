@@ -19,15 +19,84 @@ struct local
     : std::vector<T, memory::allocator<T> >(__n, __value)
     { }
 
+    /**
+     * n default initialized elements, for trivial T the memory is not
+     * touched; before C++11 the elements are value initialized
+     */
+    vector(std::size_t __n, memory::uninitialized_t)
+#if __cplusplus >= 201103L
+    : std::vector<T, memory::allocator<T> >()
+    {
+      memory::uninitialized_scope scope;
+      std::vector<T, memory::allocator<T> >::resize(__n);
+    }
+#else
+    : std::vector<T, memory::allocator<T> >(__n, T())
+    { }
+#endif
+
     vector(const vector& __x)
     : std::vector<T, memory::allocator<T> >(__x)
     { }
 
+#if __cplusplus >= 201103L
+    vector(vector&& __x)
+    : std::vector<T, memory::allocator<T> >(std::move(__x))
+    { }
+
+    vector& operator=(const vector& __x)
+    {
+      std::vector<T, memory::allocator<T> >::operator=(__x);
+      return *this;
+    }
+
+    vector& operator=(vector&& __x)
+    {
+      std::vector<T, memory::allocator<T> >::operator=(std::move(__x));
+      return *this;
+    }
+#endif
+
     template<typename _InputIterator>
     vector(_InputIterator __first, _InputIterator __last)
     : std::vector<T, memory::allocator<T> >(__first, __last)
     { }
 
+    using std::vector<T, memory::allocator<T> >::resize;
+
+    /**
+     * resize without initializing new elements, see above
+     */
+    void resize(std::size_t __n, memory::uninitialized_t)
+    {
+#if __cplusplus >= 201103L
+      memory::uninitialized_scope scope;
+      std::vector<T, memory::allocator<T> >::resize(__n);
+#else
+      std::vector<T, memory::allocator<T> >::resize(__n, T());
+#endif
+    }
+
+  };
+
+  template<class T>
+  struct image : public vector<T>
+  {
+    std::size_t dimX;                                 //!< number of columns
+    std::size_t dimY;                                    //!< number of rows
+
+    image()
+    : vector<T>(), dimX(0), dimY(0) { }
+
+    image(std::size_t __dimX, std::size_t __dimY, const T& __value = T())
+    : vector<T>(__dimX * __dimY, __value), dimX(__dimX), dimY(__dimY)
+    { }
+
+    image(std::size_t __dimX, std::size_t __dimY, memory::uninitialized_t)
+    : vector<T>(__dimX * __dimY, memory::uninitialized),
+      dimX(__dimX), dimY(__dimY)
+    { }
+
   };
 };
 
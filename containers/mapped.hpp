@@ -0,0 +1,170 @@
+#ifndef MAPPED_HPP_INCLUDED
+#define MAPPED_HPP_INCLUDED
+
+#include <cstddef>
+
+#ifndef __SPU__
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/**
+ * file backed containers
+ *
+ * a mapped::vector maps a file into the address space, a remote::vector made
+ * from it streams through the file with the block iterators like through
+ * local memory; the kernel pages the data in and writes it back, see
+ * readahead_slicer for hints that follow the prefetch schedule
+ *
+ *   mapped::vector<float> in("frames.raw");            // existing, read only
+ *   mapped::vector<float> out("result.raw", in.size());  // created, writable
+ *   remote::vector<float> rin = in, rout = out;
+ *
+ */
+struct mapped
+{
+  enum access { read_only, read_write };
+
+  template<class T>
+  class vector
+  {
+
+  private: // __________________________________________________________________
+
+    T * data_;                               //!< start of the mapping or 0
+    std::size_t size_;                               //!< number of elements
+    int fd;
+    bool writable;
+
+    vector(const vector &);                              // not copyable
+    vector & operator=(const vector &);
+
+  public: // ___________________________________________________________________
+
+    /**
+     * map an existing file
+     */
+    explicit vector(const char * path, access mode = read_only) :
+      data_(0), size_(0), fd(-1), writable(mode == read_write)
+    {
+      fd = open(path, writable ? O_RDWR : O_RDONLY);
+      struct stat st;
+      if(fd >= 0)
+      {
+        map((fstat(fd, &st) == 0) ? st.st_size / sizeof(T) : 0, true);
+      }
+    }
+
+    /**
+     * create (or truncate) a file of n elements and map it writable
+     */
+    vector(const char * path, std::size_t n) :
+      data_(0), size_(0), fd(-1), writable(true)
+    {
+      fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if(fd >= 0)
+      {
+        map(n, ftruncate(fd, n * sizeof(T)) == 0);
+      }
+    }
+
+    ~vector()
+    {
+      if(data_)
+      {
+        munmap(data_, size_ * sizeof(T));
+      }
+      if(fd >= 0)
+      {
+        close(fd);
+      }
+    }
+
+    /**
+     * false if the file could not be opened or mapped
+     */
+    bool is_open() const { return fd >= 0; }
+
+    /**
+     * false if the file was opened read only
+     */
+    bool is_writable() const { return writable; }
+
+    std::size_t size() const { return size_; }
+    T * data() const { return data_; }
+    T * begin() const { return data_; }
+    T * end() const { return data_ + size_; }
+    T & operator[](std::size_t i) const { return data_[i]; }
+
+    /**
+     * hint that elements [first, first+count) are needed soon
+     */
+    void willneed(std::size_t first, std::size_t count) const
+    {
+      advise(first, count, MADV_WILLNEED);
+    }
+
+    /**
+     * hint that elements [first, first+count) are not needed again
+     */
+    void dontneed(std::size_t first, std::size_t count) const
+    {
+      advise(first, count, MADV_DONTNEED);
+    }
+
+    /**
+     * write modified pages back to the file and wait for it
+     */
+    bool sync() const
+    {
+      return !data_ || msync(data_, size_ * sizeof(T), MS_SYNC) == 0;
+    }
+
+  private:
+
+    /**
+     * map n elements of the open file, closes it if that is not possible
+     */
+    void map(std::size_t n, bool ok)
+    {
+      void * p = (ok && n > 0) ? mmap(0, n * sizeof(T),
+        writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0) : 0;
+      if(!ok || p == MAP_FAILED)
+      {
+        close(fd);
+        fd = -1;
+        return;
+      }
+      if(n == 0)
+      {
+        return;
+      }
+      madvise(p, n * sizeof(T), MADV_SEQUENTIAL);
+      data_ = (T*) p;
+      size_ = n;
+    }
+
+    void advise(std::size_t first, std::size_t count, int advice) const
+    {
+      if(!data_ || first >= size_)
+      {
+        return;
+      }
+      if(count > size_ - first)
+      {
+        count = size_ - first;
+      }
+      std::size_t page = sysconf(_SC_PAGESIZE);
+      std::size_t from = (std::size_t)(data_ + first) & ~(page - 1);
+      std::size_t to = (std::size_t)(data_ + first + count);
+      madvise((void*) from, to - from, advice);
+    }
+
+  };
+};
+
+#endif // __SPU__
+
+#endif // MAPPED_HPP_INCLUDED
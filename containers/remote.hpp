@@ -4,14 +4,16 @@
 #include <vector>
 #include <stdlib.h>
 #include <sdk/addr64.hpp>
-#include <cbe_mpi/sdk/addr64.hpp>
 #include <containers/local.hpp>
+#include <containers/mapped.hpp>
 #include <iterators/remote_block_base_iterator.hpp>
 
 #ifdef __SPE__
   #include <cbe_mpi/core/bootstrap/init.spe.hpp>
 #endif
 
+template<typename E> struct expression;         // see containers/expression.hpp
+
 struct remote
 {
   template<class T>
@@ -26,12 +28,13 @@ struct remote
 
       ext::addr64 addr;
       std::size_t size_;
+      bool writable_;                 //!< false for a read only mapped file
 
    public:
 
-    vector() : addr(0), size_(0) {}
+    vector() : addr(0), size_(0), writable_(true) {}
 
-    vector(const VectorLocalType & vec)
+    vector(const VectorLocalType & vec) : writable_(true)
     {
 #ifdef CBE_MPI_CELL_SPE_SUPPORT
       // to get the correct address we need to add the SPE's local store address
@@ -51,23 +54,95 @@ struct remote
       addr = &vec[0];
 #endif
       size_ = vec.size();
+      writable_ = true;
+      return *this;
+    }
+
+#ifndef __SPU__
+    /**
+     * stream through a mapped file, the file has to outlive the vector; a
+     * read only file can only be streamed in, the iterators that store to
+     * it assert
+     */
+    vector(const mapped::vector<T> & file)
+    {
+      addr = file.data();
+      size_ = file.size();
+      writable_ = file.is_writable();
+    }
+
+    inline VectorType & operator= (const mapped::vector<T> & file)
+    {
+      addr = file.data();
+      size_ = file.size();
+      writable_ = file.is_writable();
+      return *this;
+    }
+#endif
+
+    /**
+     * evaluate an expression of remote vectors into this one in a single
+     * streamed pass, needs containers/expression.hpp
+     */
+    template<typename E>
+    inline VectorType & operator= (const expression<E> & e)
+    {
+      e.assign_to(*this);
       return *this;
     }
 
-    std::size_t size() { return size_; }
+    std::size_t size() const { return size_; }
 
     remote_block_base_iterator<T> begin() const
     {
-      cbe_mpi::addr64 a;
+      addr64 a;
       a.ull = addr.ull;
-      return remote_block_base_iterator<T>(a);
+      return remote_block_base_iterator<T>(a, addr.ull+size_*sizeof(T),
+        writable_);
+    }
+
+    /**
+     * like begin() but transfers stop after the first n elements
+     */
+    remote_block_base_iterator<T> begin(std::size_t n) const
+    {
+      addr64 a;
+      a.ull = addr.ull;
+      n = (n < size_) ? n : size_;
+      return remote_block_base_iterator<T>(a, addr.ull+n*sizeof(T), writable_);
     }
 
     remote_block_base_iterator<T> end() const
     {
-      cbe_mpi::addr64 a;
+      addr64 a;
       a.ull = addr.ull+size_*sizeof(T);
-      return remote_block_base_iterator<T>(a);
+      return remote_block_base_iterator<T>(a, a.ull, writable_);
+    }
+
+  };
+
+  template<class T>
+  struct image : public vector<T>
+  {
+   public:
+
+    typedef typename remote::image<T> ImageType;
+    typedef typename local::image<T> ImageLocalType;
+
+    std::size_t dimX;                                 //!< number of columns
+    std::size_t dimY;                                    //!< number of rows
+
+    image() : vector<T>(), dimX(0), dimY(0) {}
+
+    image(const ImageLocalType & img)
+    : vector<T>(img), dimX(img.dimX), dimY(img.dimY) {}
+
+    inline ImageType & operator= (const ImageLocalType & img)
+    {
+      vector<T>::operator=(img);
+      dimX = img.dimX;
+      dimY = img.dimY;
+      return *this;
     }
 
   };
@@ -0,0 +1,273 @@
+#ifndef ADAPTIVE_REMOTE_BLOCK_INPUT_ITERATOR_HPP_INCLUDED
+#define ADAPTIVE_REMOTE_BLOCK_INPUT_ITERATOR_HPP_INCLUDED
+
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/clock.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+#include <sdk/stats.hpp>
+#include <slicers/any_slicer.hpp>
+
+#ifndef REMOTEBUFF_ADAPT_EPOCH
+  #define REMOTEBUFF_ADAPT_EPOCH 8             //!< blocks between two decisions
+#endif
+
+/**
+ * adaptive remote block input iterator
+ *
+ * this class iterates over a remote block like remote_block_input_iterator
+ * but picks the number of blocks in flight itself: it starts with double
+ * buffering and measures the time operator * waits for transfers against
+ * the time between two increments; every REMOTEBUFF_ADAPT_EPOCH blocks the
+ * window grows by one block if more than 1/16th of the time was spent
+ * waiting and shrinks by one after four epochs in a row that spent less
+ * than 1/64th waiting (a wait is never free, the host engine takes a lock)
+ *
+ * the window never exceeds the buffers that fit into the memory budget
+ * given on construction (and never the 31 free DMA tags); all of them are
+ * leased up front, so shrinking the window only lowers the transfers in
+ * flight, it does not give memory back
+ *
+ */
+
+template<typename T, typename Slicer = any_slicer>
+class adaptive_remote_block_input_iterator
+{
+
+private: // ____________________________________________________________________
+
+  uint8_t capacity;                             //!< buffers that fit the budget
+  uint8_t window;                                //!< blocks in flight right now
+  int size;                                   //!< number of bytes in one buffer
+
+  int * tags;                             //!< tags we use for the DMA transfers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
+
+  int block;                                     //!< index of the current block
+  int next;                                  //!< index of the next block to get
+  addr64 base_address;                   //!< base address of the data we access
+  uint64_t limit;                    //!< end of the data, transfers stop there
+                                       //! function to calculate the next access
+  Slicer addr_offset_calc;
+
+  ext::clock::ticks last;                               //!< time of the last ++
+  ext::clock::ticks period;                    //!< time between ++ in the epoch
+  ext::clock::ticks stall;                    //!< time waited in * in the epoch
+  int blocks;                                      //!< blocks seen in the epoch
+  int calm;                            //!< epochs in a row with little waiting
+#ifdef REMOTEBUFF_STATS
+  ext::stream_probe probe;                              //!< counters and trace
+#endif
+
+public: // _____________________________________________________________________
+
+  /**
+   * ctor, budget is the number of bytes the buffers may take
+   */
+  adaptive_remote_block_input_iterator(uint32_t budget, int _size,
+    const Slicer & _addr_offset_calc, int * _tags = 0) :
+    size(_size*sizeof(T)), block(0), next(0), limit(~0ull),
+    addr_offset_calc(_addr_offset_calc)
+  {
+    uint32_t fit = budget / memory::arena::align(size);
+    capacity = (fit < 2) ? 2 : (fit > ext::dma_tags::count-1) ?
+      ext::dma_tags::count-1 : fit;
+    window = 2;
+    memory::arena::lease_buffers(capacity, size, buffers, tags);
+    owned = ext::dma_tags::acquire(tags, capacity, _tags);
+    REMOTEBUFF_PROBE(open("adaptive", capacity));
+  }
+
+  /**
+   * assignment operator (to assign to remote vector for example)
+   */
+  inline adaptive_remote_block_input_iterator & operator= (
+    const ext::addr64 & base_address_)
+  {
+    base_address.ull = base_address_.ull;
+    limit = ~0ull;
+    init();
+    return *this;
+  }
+
+  /**
+   * assignment operator (to assign to remote vector for example)
+   */
+  inline adaptive_remote_block_input_iterator & operator= (
+    const remote_block_base_iterator<T> & it)
+  {
+    base_address.ull = it.address().ull;
+    limit = it.limit();
+    init();
+    return *this;
+  }
+
+  /**
+   * indirection operator to get a pointer to the current finished data
+   */
+  inline T* operator *()
+  {
+    ext::clock::ticks start = ext::clock::now();
+    REMOTEBUFF_PROBE(enter());
+    dma_synchronize_c(tags[block % capacity]);
+    REMOTEBUFF_PROBE(waited(block % capacity));
+    stall += ext::clock::now() - start;
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(
+      buffers[block % capacity]);
+  }
+
+  /**
+   * increment operator to advance the iterator to the next block
+   */
+  inline void operator ++(int)
+  {
+    ext::clock::ticks now = ext::clock::now();
+    period += now - last;
+    last = now;
+    REMOTEBUFF_PROBE(advance());
+    block++;
+    if(++blocks == REMOTEBUFF_ADAPT_EPOCH)
+    {
+      adapt();
+    }
+    fill();
+  }
+
+  /**
+   * number of valid elements in the current block, smaller than the block
+   * for the final one of the data
+   */
+  inline int count()
+  {
+    int32_t addr_offset = addr_offset_calc(block);
+    return (addr_offset < 0) ? 0 : clamp(addr_offset) / sizeof(T);
+  }
+
+  /**
+   * number of blocks currently kept in flight
+   */
+  int depth() const
+  {
+    return window;
+  }
+
+  ~adaptive_remote_block_input_iterator()
+  {
+    ext::dma_tags::wait(tags, capacity);       // transfers may still be running
+    REMOTEBUFF_PROBE(drain());
+    ext::dma_tags::release(owned);
+    memory::arena::release_buffers(capacity, size, buffers);
+  }
+
+#ifdef REMOTEBUFF_STATS
+  /**
+   * counters of this iterator
+   */
+  const ext::stream_stats & stats() const
+  {
+    return probe.stats();
+  }
+#endif
+
+  /**
+   * less than operator
+   */
+  bool operator <(const remote_block_base_iterator<T> b) const
+  {
+    int32_t offset = addr_offset_calc(block);
+    return offset >= 0 &&
+      b.address().ull > base_address.ull+(uint64_t)offset*sizeof(T);
+  }
+
+  /**
+   * greater than operator
+   */
+  bool operator >(const remote_block_base_iterator<T> b) const
+  {
+    return !(*this < b);
+  }
+
+ private:
+
+  /**
+   * grow or shrink the window from the measurements of the last epoch
+   */
+  void adapt()
+  {
+    if(stall * 16 > period && window < capacity)
+    {
+      window++;
+      calm = 0;
+    }
+    else if(stall * 64 < period)
+    {
+      if(++calm >= 4 && window > 2)
+      {
+        window--;
+        calm = 0;
+      }
+    }
+    else
+    {
+      calm = 0;
+    }
+    stall = 0;
+    period = 0;
+    blocks = 0;
+  }
+
+  /**
+   * start transfers until window blocks are in flight
+   */
+  void fill()
+  {
+    for(; next < block + window; next++)
+    {
+      int32_t addr_offset = addr_offset_calc(next);
+      if(addr_offset < 0)   // we don't fetch data if address offset is negative
+      {
+        continue;
+      }
+      uint8_t i = next % capacity;
+      REMOTEBUFF_PROBE(enter());
+      dma_synchronize_c(tags[i]);      // the block before may not be waited for
+      REMOTEBUFF_PROBE(waited(i, false));
+      int bytes = clamp(addr_offset);
+      spe_ppe_get_tail_async_c(buffers[i],
+        base_address+(addr_offset*sizeof(T)), bytes, tags[i]);
+      REMOTEBUFF_PROBE(got(i, bytes, next));
+    }
+  }
+
+  /**
+   * bytes of the block at addr_offset that lie before the end of the data
+   */
+  int clamp(int32_t addr_offset) const
+  {
+    uint64_t at = base_address.ull + addr_offset*sizeof(T);
+    if(at >= limit)
+    {
+      return 0;
+    }
+    return (limit - at < (uint64_t)size) ? limit - at : size;
+  }
+
+  void init()
+  {
+    ext::dma_tags::wait(tags, capacity);
+    block = 0;
+    next = 0;
+    stall = 0;
+    period = 0;
+    blocks = 0;
+    calm = 0;
+    fill();
+    last = ext::clock::now();
+  }
+
+};
+
+
+#endif // ADAPTIVE_REMOTE_BLOCK_INPUT_ITERATOR_HPP_INCLUDED
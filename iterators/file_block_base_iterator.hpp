@@ -0,0 +1,72 @@
+#ifndef FILE_BLOCK_BASE_ITERATOR_HPP_INCLUDED
+#define FILE_BLOCK_BASE_ITERATOR_HPP_INCLUDED
+
+#include <stdint.h>
+
+#ifndef REMOTEBUFF_DIRECT_ALIGNMENT
+  #define REMOTEBUFF_DIRECT_ALIGNMENT 4096          //!< granularity of O_DIRECT
+#endif
+
+/**
+ * file block iterator
+ *
+ * this class is a dummy iterator that is used for assignment and comparison
+ * of file iterators, like remote_block_base_iterator for memory; it also
+ * carries the end of the data, the file block iterators clamp their
+ * transfers to it
+ *
+ */
+template<typename T>
+class file_block_base_iterator
+{
+
+private: // ____________________________________________________________________
+
+  int fd;                                               //!< buffered descriptor
+  int direct_fd;                                  //!< O_DIRECT descriptor or -1
+  uint64_t offset_;                                     //!< byte offset in file
+  uint64_t limit_;                         //!< end of the data, ~0 if unbounded
+
+public: // _____________________________________________________________________
+
+  file_block_base_iterator() : fd(-1), direct_fd(-1), offset_(0),
+    limit_(~0ull) {}
+  file_block_base_iterator(int fd_, int direct_fd_, uint64_t offset__,
+    uint64_t limit__ = ~0ull) :
+    fd(fd_), direct_fd(direct_fd_), offset_(offset__), limit_(limit__) {}
+  int descriptor() const { return fd; }
+  int direct_descriptor() const { return direct_fd; }
+  uint64_t offset() const { return offset_; }
+  uint64_t limit() const { return limit_; }
+
+  /**
+   * bytes of a transfer of bytes bytes at byte offset at that lie before
+   * the end of the data
+   */
+  int clamp(uint64_t at, int bytes) const
+  {
+    if(at >= limit_)
+    {
+      return 0;
+    }
+    return (limit_ - at < (uint64_t)bytes) ? limit_ - at : bytes;
+  }
+
+  /**
+   * descriptor for a transfer of bytes bytes at byte offset at from or to
+   * buf, the O_DIRECT one if everything is aligned for it
+   */
+  int descriptor(const void * buf, uint64_t at, int bytes) const
+  {
+    if(direct_fd >= 0 && (((uintptr_t)buf | at | (uint64_t)bytes) &
+       (REMOTEBUFF_DIRECT_ALIGNMENT - 1)) == 0)
+    {
+      return direct_fd;
+    }
+    return fd;
+  }
+
+};
+
+
+#endif // FILE_BLOCK_BASE_ITERATOR_HPP_INCLUDED
@@ -0,0 +1,162 @@
+#ifndef FILE_BLOCK_INPUT_ITERATOR_HPP_INCLUDED
+#define FILE_BLOCK_INPUT_ITERATOR_HPP_INCLUDED
+
+#include <memory/arena.hpp>
+#include <sdk/uring.hpp>
+#include <sdk/dma_tags.hpp>
+#include <slicers/any_slicer.hpp>
+#include <iterators/file_block_base_iterator.hpp>
+
+/**
+ * file block input iterator
+ *
+ * this class can iterate over a file in a multi-buffering manner, block n
+ * is read from the element offset the slicer returns for n while the
+ * blocks before it are processed; offsets are 64 bit, see any_file_slicer
+ *
+ */
+
+template<typename T, typename Slicer = any_file_slicer>
+class file_block_input_iterator
+{
+
+private: // ____________________________________________________________________
+
+  uint8_t depth;                                 //!< the number of buffers used
+  int size;                                   //!< number of bytes in one buffer
+  uint8_t current;                        //!<  which buffer is currently in use
+
+  int * tags;                            //!< tags we use for the file transfers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
+  int valid;                          //!< elements read into the current buffer
+
+  int n;                                               //!< number of iterations
+  file_block_base_iterator<T> file;                   //!< the file we read from
+                                       //! function to calculate the next access
+  Slicer addr_offset_calc;
+
+public: // _____________________________________________________________________
+
+  /**
+   * ctor
+   */
+  file_block_input_iterator(uint8_t _depth, int _size,
+    const Slicer & _addr_offset_calc, int * _tags = 0) :
+    depth(_depth), size(_size*sizeof(T)), current(0), valid(0), n(0),
+    addr_offset_calc(_addr_offset_calc)
+  {
+    memory::arena::lease_buffers(depth, size, buffers, tags);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+  }
+
+  /**
+   * assignment operator (to assign to a disk vector for example)
+   */
+  inline file_block_input_iterator & operator= (
+    const file_block_base_iterator<T> & it)
+  {
+    file = it;
+    init();
+    return *this;
+  }
+
+  /**
+   * indirection operator to get a pointer to the current finished data
+   */
+  inline T* operator *()
+  {
+    int64_t bytes = file_synchronize_c(tags[current]);
+    if(bytes != 0)                             // 0 if it was waited for already
+    {
+      valid = (bytes > 0) ? bytes / sizeof(T) : 0;
+    }
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(buffers[current]);
+  }
+
+  /**
+   * number of elements read into the current buffer, smaller than the
+   * block at the end of the file and 0 after a failed read
+   */
+  inline int count()
+  {
+    **this;
+    return valid;
+  }
+
+  /**
+   * increment operator to advance the iterator to the next block
+   */
+  inline void operator ++(int)
+  {
+                   // we are finished with current buffer, start load of new one
+    int64_t addr_offset = addr_offset_calc(n);
+    if(addr_offset >= 0)    // we don't fetch data if address offset is negative
+    {
+      fetch(n%depth, addr_offset);
+    }
+    n++;
+    current = (current + 1) % depth;
+    valid = 0;
+  }
+
+  ~file_block_input_iterator()
+  {
+    for(uint8_t i=0; i<depth; i++)             // transfers may still be running
+    {
+      file_synchronize_c(tags[i]);
+    }
+    ext::dma_tags::release(owned);
+    memory::arena::release_buffers(depth, size, buffers);
+  }
+
+  /**
+   * less than operator
+   */
+  bool operator <(const file_block_base_iterator<T> b) const
+  {
+                               // offset of the current block, it may be partial
+    int64_t next_offset = addr_offset_calc(n-depth);
+    return next_offset >= 0 &&
+      b.offset() > file.offset()+(uint64_t)next_offset*sizeof(T);
+  }
+
+  /**
+   * greater than operator
+   */
+  bool operator >(const file_block_base_iterator<T> b) const
+  {
+    return !(*this < b);
+  }
+
+ private:
+
+  void fetch(uint8_t i, int64_t addr_offset)
+  {
+    uint64_t at = file.offset() + (uint64_t)addr_offset*sizeof(T);
+    int bytes = file.clamp(at, size);
+    if(bytes > 0)
+    {
+      file_read_async_c(buffers[i], file.descriptor(buffers[i], at, bytes), at,
+        bytes, tags[i]);
+    }
+  }
+
+  void init()
+  {
+    current = 0;
+    valid = 0;
+    for(n=0; n<depth; n++)                                    // start transfers
+    {
+      int64_t addr_offset = addr_offset_calc(n);
+      if(addr_offset >= 0)  // we don't fetch data if address offset is negative
+      {
+        fetch(n, addr_offset);
+      }
+    }
+  }
+
+};
+
+
+#endif // FILE_BLOCK_INPUT_ITERATOR_HPP_INCLUDED
@@ -0,0 +1,174 @@
+#ifndef FILE_BLOCK_OUTPUT_ITERATOR_HPP_INCLUDED
+#define FILE_BLOCK_OUTPUT_ITERATOR_HPP_INCLUDED
+
+#include <memory/arena.hpp>
+#include <sdk/uring.hpp>
+#include <sdk/dma_tags.hpp>
+#include <slicers/any_slicer.hpp>
+#include <iterators/file_block_base_iterator.hpp>
+
+/**
+ * file block output iterator
+ *
+ * this class can iterate over a file in a multi-buffering manner, block n
+ * is written to the element offset the slicer returns for n while the
+ * blocks after it are produced; writes stop at the end of the data, the
+ * final block does not grow the file; offsets are 64 bit, see any_file_slicer
+ *
+ */
+
+template<typename T, typename Slicer = any_file_slicer>
+class file_block_output_iterator
+{
+
+private: // ____________________________________________________________________
+
+  uint8_t depth;                                 //!< the number of buffers used
+  int size;                                   //!< number of bytes in one buffer
+  uint8_t current;                        //!<  which buffer is currently in use
+
+  int * tags;                            //!< tags we use for the file transfers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
+
+  int n;                                               //!< number of iterations
+  file_block_base_iterator<T> file;                    //!< the file we write to
+                                       //! function to calculate the next access
+  Slicer addr_offset_calc;
+  bool dirty;                   //!< indicate if the current buffer was accessed
+  bool failed;                                    //!< a write returned an error
+
+public: // _____________________________________________________________________
+
+  /**
+   * ctor
+   */
+  file_block_output_iterator(uint8_t _depth, int _size,
+    const Slicer & _addr_offset_calc, int * _tags = 0) :
+    depth(_depth), size(_size*sizeof(T)), current(0), n(0),
+    addr_offset_calc(_addr_offset_calc), dirty(false), failed(false)
+  {
+    memory::arena::lease_buffers(depth, size, buffers, tags);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+  }
+
+  /**
+   * assignment operator (to assign to a disk vector for example), the blocks
+   * of the previous file are written out first
+   */
+  inline file_block_output_iterator & operator= (
+    const file_block_base_iterator<T> & it)
+  {
+    drain();
+    file = it;
+    current = 0;
+    n = 0;
+    dirty = false;
+    return *this;
+  }
+
+  /**
+   * indirection operator to get a pointer to a free buffer for the current
+   * block
+   */
+  inline T* operator *()
+  {
+    wait(current);
+    dirty = true;
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(buffers[current]);
+  }
+
+  /**
+   * increment operator to advance the iterator to the next block
+   */
+  inline void operator ++(int)
+  {
+    dirty = false;
+                                // we are finished with current buffer, store it
+    int64_t addr_offset = addr_offset_calc(n);
+    if(addr_offset >= 0)            // we don't store data if offset is negative
+    {
+      store(addr_offset);
+    }
+    n++;
+    current = (current + 1) % depth;
+  }
+
+  /**
+   * false if a write that was waited for failed
+   */
+  bool good() const
+  {
+    return !failed;
+  }
+
+  ~file_block_output_iterator()
+  {
+    drain();
+    ext::dma_tags::release(owned);
+    memory::arena::release_buffers(depth, size, buffers);
+  }
+
+  /**
+   * less than operator
+   */
+  bool operator <(const file_block_base_iterator<T> b) const
+  {
+    int64_t next_offset = addr_offset_calc(n);
+    return next_offset >= 0 &&
+      b.offset() > file.offset()+(uint64_t)next_offset*sizeof(T);
+  }
+
+  /**
+   * greater than operator
+   */
+  bool operator >(const file_block_base_iterator<T> b) const
+  {
+    return !(*this < b);
+  }
+
+ private:
+
+  void store(int64_t addr_offset)
+  {
+    uint64_t at = file.offset() + (uint64_t)addr_offset*sizeof(T);
+    int bytes = file.clamp(at, size);
+    if(bytes > 0)
+    {
+      file_write_async_c(file.descriptor(buffers[current], at, bytes), at,
+        buffers[current], bytes, tags[current]);
+    }
+  }
+
+  /**
+   * store the current block if it was touched and wait for all writes
+   */
+  void drain()
+  {
+    if(dirty)           // store the last block because it probably was modified
+    {
+      int64_t addr_offset = addr_offset_calc(n);
+      if(addr_offset >= 0)          // we don't store data if offset is negative
+      {
+        store(addr_offset);
+      }
+      dirty = false;
+    }
+    for(uint8_t i=0; i<depth; i++)             // transfers may still be running
+    {
+      wait(i);
+    }
+  }
+
+  void wait(uint8_t i)
+  {
+    if(file_synchronize_c(tags[i]) < 0)            // short writes are continued
+    {
+      failed = true;
+    }
+  }
+
+};
+
+
+#endif // FILE_BLOCK_OUTPUT_ITERATOR_HPP_INCLUDED
@@ -1,14 +1,15 @@
 #ifndef REMOTE_BLOCK_BASE_ITERATOR_HPP_INCLUDED
 #define REMOTE_BLOCK_BASE_ITERATOR_HPP_INCLUDED
 
-#include <cbe_mpi/core/memalign/aligned_ptr.hpp>
-#include <cbe_mpi/core/memalign/aligned_malloc.hpp>
-#include <cbe_mpi/sdk/addr64.hpp>
+#include <stdint.h>
+#include <sdk/addr64.hpp>
 /**
- * remote block iterator
- *
- * this class is a dummy iterator that is used for assignment and comparison
- * of remote iterators
+ * remote block iterator
+ *
+ * this class is a dummy iterator that is used for assignment and comparison
+ * of remote iterators; it also carries the end of the data it was taken
+ * from, the block iterators clamp their transfers to it, and whether that
+ * data may be written, the iterators that store assert it
  *
  */
 template<typename T>
@@ -17,15 +18,21 @@ class remote_block_base_iterator
 
 private: // ____________________________________________________________________
 
-  cbe_mpi::addr64 base_address;          //!< base address of the data we access
+  addr64 base_address;                   //!< base address of the data we access
+  uint64_t limit_;                        //!< end of the data, ~0 if unbounded
+  bool writable_;                          //!< false for read only mapped files
 
 public: // _____________________________________________________________________
 
-  remote_block_base_iterator() : base_address(0) {}
-  remote_block_base_iterator(cbe_mpi::addr64 base_address_) :
-    base_address(base_address_) {}
+  remote_block_base_iterator() :
+    base_address(0), limit_(~0ull), writable_(true) {}
+  remote_block_base_iterator(addr64 base_address_,
+    uint64_t limit__ = ~0ull, bool writable__ = true) :
+    base_address(base_address_), limit_(limit__), writable_(writable__) {}
   ~remote_block_base_iterator() {};
-  cbe_mpi::addr64 address() const { return base_address; }
+  addr64 address() const { return base_address; }
+  uint64_t limit() const { return limit_; }
+  bool writable() const { return writable_; }
 
 };
 
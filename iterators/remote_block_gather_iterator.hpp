@@ -0,0 +1,200 @@
+#ifndef REMOTE_BLOCK_GATHER_ITERATOR_HPP_INCLUDED
+#define REMOTE_BLOCK_GATHER_ITERATOR_HPP_INCLUDED
+
+#include <assert.h>
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+#include <slicers/list_slicer.hpp>
+
+/**
+ * remote block gather iterator
+ *
+ * this class iterates over blocks made of several non-contiguous runs in a
+ * multi-buffering manner, the runs of a block come from a list slicer and are
+ * gathered with one batched transfer into a packed buffer
+ *
+ * a block must not have more than size elements in total and every run has
+ * to lie inside the data the iterator was assigned from, both are asserted
+ *
+ */
+
+template<typename T, typename Slicer>
+class remote_block_gather_iterator
+{
+
+private: // ____________________________________________________________________
+
+  uint8_t depth;                                 //!< the number of buffers used
+  int size;                                   //!< number of bytes in one buffer
+  uint8_t current;                        //!<  which buffer is currently in use
+
+  int * tags;                             //!< tags we use for the DMA transfers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
+  ext::dma_segment * lists;      //!< dma lists, they live until the transfer
+  segment * runs;                          //!< runs of a block from the slicer
+  int * counts;                    //!< number of packed elements per buffer
+
+  int n;                                               //!< number of iterations
+  addr64 base_address;                   //!< base address of the data we access
+  uint64_t limit;                      //!< end of the data, runs must end there
+  Slicer slicer;                          //!< calculates the runs of a block
+
+public: // _____________________________________________________________________
+
+  /**
+   * ctor
+   */
+  remote_block_gather_iterator(uint8_t _depth, int _size,
+    const Slicer & _slicer, int * _tags = 0) :
+    depth(_depth), size(_size*sizeof(T)), current(0), n(0), limit(~0ull),
+    slicer(_slicer)
+  {
+    counts = (int*) malloc(sizeof(int) * depth);
+    lists = (ext::dma_segment*) malloc(
+      sizeof(ext::dma_segment) * depth * slicer.max_segments);
+    runs = (segment*) malloc(sizeof(segment) * slicer.max_segments);
+    memory::arena::lease_buffers(depth, size, buffers, tags);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+    for(uint8_t i=0; i<depth; i++)
+    {
+      counts[i] = 0;
+    }
+  }
+
+  /**
+   * assignment operator (to assign to remote vector for example)
+   */
+  inline remote_block_gather_iterator & operator= (
+    const ext::addr64 & base_address_)
+  {
+    base_address.ull = base_address_.ull;
+    limit = ~0ull;
+    init();
+    return *this;
+  }
+
+  /**
+   * assignment operator (to assign to remote vector for example)
+   */
+  inline remote_block_gather_iterator & operator= (
+    const remote_block_base_iterator<T> & it)
+  {
+    base_address.ull = it.address().ull;
+    limit = it.limit();
+    init();
+    return *this;
+  }
+
+  /**
+   * indirection operator to get a pointer to the current packed data
+   */
+  inline T* operator *()
+  {
+    dma_synchronize_c(tags[current]);
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(buffers[current]);
+  }
+
+  /**
+   * number of packed elements in the current block
+   */
+  inline int count() const
+  {
+    return counts[current];
+  }
+
+  /**
+   * increment operator to advance the iterator to the next block
+   */
+  inline void operator ++(int)
+  {
+                   // we are finished with current buffer, start load of new one
+    fetch(current, n);
+    n++;
+    current = (current + 1) % depth;
+  }
+
+  ~remote_block_gather_iterator()
+  {
+    uinit();
+  }
+
+  /**
+   * less than operator, true while the current block exists
+   */
+  bool operator <(const remote_block_base_iterator<T>) const
+  {
+    return counts[current] > 0;
+  }
+
+  /**
+   * greater than operator
+   */
+  bool operator >(const remote_block_base_iterator<T> b) const
+  {
+    return !(*this < b);
+  }
+
+ private:
+
+  /**
+   * start the gather of block k into buffer i
+   */
+  void fetch(uint8_t i, uint32_t k)
+  {
+    int m = slicer(k, runs);
+    counts[i] = 0;
+    if(m <= 0)               // we don't fetch data if there is no such block
+    {
+      return;
+    }
+    assert(m <= slicer.max_segments);
+    if(m > slicer.max_segments)
+    {
+      m = slicer.max_segments;
+    }
+    ext::dma_segment * list = lists + i*slicer.max_segments;
+    int room = size / sizeof(T);                 // elements the buffer can take
+    int j = 0;
+    for(; j<m; j++)
+    {
+      assert(runs[j].length <= room - counts[i]);
+      assert(base_address.ull + ((uint64_t)runs[j].offset + runs[j].length) *
+        sizeof(T) <= limit);
+      if(runs[j].length > room - counts[i])       // never write past the buffer
+      {
+        break;
+      }
+      list[j].offset = runs[j].offset*sizeof(T);
+      list[j].size = runs[j].length*sizeof(T);
+      counts[i] += runs[j].length;
+    }
+    spe_ppe_getl_async_c(buffers[i], base_address, list, j, tags[i]);
+  }
+
+  void init()
+  {
+    current = 0;
+    for(n=0; n<depth; n++)                                    // start transfers
+    {
+      fetch(n, n);
+    }
+  }
+
+  void uinit()
+  {
+    ext::dma_tags::wait(tags, depth);          // transfers may still be running
+    ext::dma_tags::release(owned);
+    free(counts);
+    free(lists);
+    free(runs);
+    memory::arena::release_buffers(depth, size, buffers);
+  }
+
+
+};
+
+
+#endif // REMOTE_BLOCK_GATHER_ITERATOR_HPP_INCLUDED
@@ -1,8 +1,12 @@
 #ifndef REMOTE_BLOCK_INPUT_ITERATOR_HPP_INCLUDED
 #define REMOTE_BLOCK_INPUT_ITERATOR_HPP_INCLUDED
 
-#include <cbe_mpi/core/memalign/aligned_ptr.hpp>
-#include <cbe_mpi/core/memalign/aligned_malloc.hpp>
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+#include <sdk/stats.hpp>
+#include <slicers/any_slicer.hpp>
 
 /**
  * remote block input iterator
@@ -11,7 +15,7 @@
  *
  */
 
-template<typename T>
+template<typename T, typename Slicer = any_slicer>
 class remote_block_input_iterator
 {
 
@@ -22,12 +26,17 @@ private: // ____________________________________________________________________
   uint8_t current;                        //!<  which buffer is currently in use
 
   int * tags;                             //!< tags we use for the DMA transfers
-  aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT> * buffers;                 //!< buffers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
 
   int n;                                               //!< number of iterations
   addr64 base_address;                   //!< base address of the data we access
+  uint64_t limit;                    //!< end of the data, transfers stop there
                                        //! function to calculate the next access
-  boost::function<int32_t (uint32_t n)> addr_offset_calc;
+  Slicer addr_offset_calc;
+#ifdef REMOTEBUFF_STATS
+  ext::stream_probe probe;                              //!< counters and trace
+#endif
 
 public: // _____________________________________________________________________
 
@@ -35,19 +44,13 @@ public: // _____________________________________________________________________
    * ctor
    */
   remote_block_input_iterator(uint8_t _depth, int _size,
-    boost::function<int32_t (uint32_t n)> _addr_offset_calc, int * _tags = 0) :
-    depth(_depth), size(_size*sizeof(T)), current(0), n(0),
+    const Slicer & _addr_offset_calc, int * _tags = 0) :
+    depth(_depth), size(_size*sizeof(T)), current(0), n(0), limit(~0ull),
     addr_offset_calc(_addr_offset_calc)
   {
-    tags = (int*) malloc(sizeof(int) * depth);
-    buffers = (aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT> *) malloc(
-      sizeof(aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT>)*depth);
-    for(uint8_t i=0; i<depth; i++)               // allocate and initialize data
-    {
-      buffers[i] = (aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT>)
-        aligned_malloc<CBE_MPI_DATA_ALIGNMENT>(size);
-      tags[i] = (_tags) ? _tags[i] : i+1;
-    }
+    memory::arena::lease_buffers(depth, size, buffers, tags);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+    REMOTEBUFF_PROBE(open("input", depth));
   }
 
   /**
@@ -57,6 +60,7 @@ public: // _____________________________________________________________________
     const ext::addr64 & base_address_)
   {
     base_address.ull = base_address_.ull;
+    limit = ~0ull;
     init();
     return *this;
   }
@@ -68,6 +72,7 @@ public: // _____________________________________________________________________
     const remote_block_base_iterator<T> & it)
   {
     base_address.ull = it.address().ull;
+    limit = it.limit();
     init();
     return *this;
   }
@@ -77,8 +82,39 @@ public: // _____________________________________________________________________
    */
   inline T* operator *()
   {
+    REMOTEBUFF_PROBE(enter());
     dma_synchronize_c(tags[current]);
-    return buffers[current].get();
+    REMOTEBUFF_PROBE(waited(current));
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(buffers[current]);
+  }
+
+  /**
+   * true if the current block has arrived, operator * does not block then;
+   * on the PPE cbe_mpi has no test, there dma_test_c waits for the block
+   */
+  inline bool ready() const
+  {
+    return dma_test_c(tags[current]);
+  }
+
+  /**
+   * pointer to the current block if it has arrived, 0 otherwise, so a
+   * scheduler can serve whichever stream is ready and ++ it; it does not
+   * block on the SPU and the host engine but waits like ready() on the PPE
+   */
+  inline T* try_get()
+  {
+    return ready() ? **this : 0;
+  }
+
+  /**
+   * number of valid elements in the current block, smaller than the block
+   * for the final one of the data
+   */
+  inline int count()
+  {
+    int32_t addr_offset = addr_offset_calc(n-depth);
+    return (addr_offset < 0) ? 0 : clamp(addr_offset) / sizeof(T);
   }
 
   /**
@@ -88,12 +124,14 @@ public: // _____________________________________________________________________
   {
                    // we are finished with current buffer, start laod of new one
     int32_t addr_offset = addr_offset_calc(n);
-    if(addr_offset < 0)   // we don't fetch data if address offset is negative
+    if(addr_offset >= 0)  // we don't fetch data if address offset is negative
     {
-      return;
+      int bytes = clamp(addr_offset);
+      spe_ppe_get_tail_async_c(buffers[n%depth], base_address+
+                               (addr_offset*sizeof(T)), bytes, tags[n%depth]);
+      REMOTEBUFF_PROBE(got(n%depth, bytes, n));
     }
-    spe_ppe_get_async_c(buffers[n%depth].get(), base_address+
-                        (addr_offset*sizeof(T)), size, tags[n%depth]);
+    REMOTEBUFF_PROBE(advance());
     n++;
     current = (current + 1) % depth;
     return;
@@ -104,16 +142,26 @@ public: // _____________________________________________________________________
     uinit();
   }
 
+#ifdef REMOTEBUFF_STATS
+  /**
+   * counters of this iterator
+   */
+  const ext::stream_stats & stats() const
+  {
+    return probe.stats();
+  }
+#endif
+
   /**
    * less than operator
    */
   bool operator <(const remote_block_base_iterator<T> b) const
   {
-           // offset that was used for data that is current after next increment
-    int32_t next_offset = addr_offset_calc(n-depth)*sizeof(T);
+                               // offset of the current block, it may be partial
+    int32_t next_offset = addr_offset_calc(n-depth);
     addr64 baddr = b.address();
-    if(next_offset >= 0 && baddr.ull >=
-       base_address.ull+next_offset+size)
+    if(next_offset >= 0 && baddr.ull >
+       base_address.ull+(uint64_t)next_offset*sizeof(T))
     {
       return true;
     }
@@ -125,10 +173,10 @@ public: // _____________________________________________________________________
    */
   bool operator >(const remote_block_base_iterator<T> b) const
   {
-           // offset that was used for data that is current after next increment
-    int32_t next_offset = addr_offset_calc(n-depth)*sizeof(T);
+                               // offset of the current block, it may be partial
+    int32_t next_offset = addr_offset_calc(n-depth);
     if(next_offset < 0 || b.address().ull <=
-       base_address.ull+next_offset+size)
+       base_address.ull+(uint64_t)next_offset*sizeof(T))
     {
       return true;
     }
@@ -137,6 +185,19 @@ public: // _____________________________________________________________________
 
  private:
 
+  /**
+   * bytes of the block at addr_offset that lie before the end of the data
+   */
+  int clamp(int32_t addr_offset) const
+  {
+    uint64_t at = base_address.ull + addr_offset*sizeof(T);
+    if(at >= limit)
+    {
+      return 0;
+    }
+    return (limit - at < (uint64_t)size) ? limit - at : size;
+  }
+
   void init()
   {
     current = 0;
@@ -144,24 +205,23 @@ public: // _____________________________________________________________________
     for(uint8_t i=0; i<depth; i++)                            // start transfers
     {
       int32_t addr_offset = addr_offset_calc(n);
-      if(addr_offset < 0)   // we don't fetch data if address offset is negative
+      if(addr_offset >= 0)  // we don't fetch data if address offset is negative
       {
-        return;
+        int bytes = clamp(addr_offset);
+        spe_ppe_get_tail_async_c(buffers[i],
+          base_address+(addr_offset*sizeof(T)), bytes, tags[i]);
+        REMOTEBUFF_PROBE(got(i, bytes, n));
       }
-      spe_ppe_get_async_c(buffers[i].get(),
-        base_address+(addr_offset*sizeof(T)), size, tags[i]);
       n++;
     }
   }
 
   void uinit()
   {
-    for(uint8_t i=0; i<depth; i++)                               // free buffers
-    {
-      aligned_free(buffers[i]);
-    }
-    free(tags);
-    free(buffers);
+    ext::dma_tags::wait(tags, depth);          // transfers may still be running
+    REMOTEBUFF_PROBE(drain());
+    ext::dma_tags::release(owned);
+    memory::arena::release_buffers(depth, size, buffers);
   }
 
 
@@ -1,8 +1,13 @@
 #ifndef REMOTE_BLOCK_ITERATOR_HPP_INCLUDED
 #define REMOTE_BLOCK_ITERATOR_HPP_INCLUDED
 
-#include <cbe_mpi/core/memalign/aligned_ptr.hpp>
-#include <cbe_mpi/core/memalign/aligned_malloc.hpp>
+#include <assert.h>
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+#include <sdk/stats.hpp>
+#include <slicers/any_slicer.hpp>
 
 /**
  * remote block input iterator
@@ -11,7 +16,7 @@
  *
  */
 
-template<typename T>
+template<typename T, typename Slicer = any_slicer>
 class remote_block_iterator
 {
 
@@ -23,13 +28,18 @@ private: // ____________________________________________________________________
   uint8_t ahead;             //!< helper variable that specifies preload buffers
 
   int * tags;                             //!< tags we use for the DMA transfers
-  aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT> * buffers;                 //!< buffers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
 
   int n;                                               //!< number of iterations
   addr64 base_address;              //!< base address of the data we access
+  uint64_t limit;                    //!< end of the data, transfers stop there
                                        //! function to calculate the next access
-  boost::function<int32_t (uint32_t n)> addr_offset_calc;
+  Slicer addr_offset_calc;
   bool dirty;                   //!< indicate if the current buffer was accessed
+#ifdef REMOTEBUFF_STATS
+  ext::stream_probe probe;                              //!< counters and trace
+#endif
 
 public: // _____________________________________________________________________
 
@@ -37,9 +47,9 @@ public: // _____________________________________________________________________
    * ctor
    */
   remote_block_iterator(uint8_t _depth, int _size,
-    boost::function<int32_t (uint32_t n)> _addr_offset_calc, int * _tags = 0) :
+    const Slicer & _addr_offset_calc, int * _tags = 0) :
     depth(_depth), size(_size*sizeof(T)), current(0), ahead(depth/2), n(0),
-    addr_offset_calc(_addr_offset_calc), dirty(false)
+    limit(~0ull), addr_offset_calc(_addr_offset_calc), dirty(false)
   {
     if(depth < 3)                   // minimum depth size is 3 for this iterator
     {
@@ -50,15 +60,9 @@ public: // _____________________________________________________________________
       depth++;
     }
 
-    tags = (int*) malloc(sizeof(int) * depth);
-    buffers = (aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT> *) malloc(
-      sizeof(aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT>)*depth);
-    for(uint8_t i=0; i<depth; i++)               // allocate and initialize data
-    {
-      buffers[i] = (aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT>)
-        aligned_malloc<CBE_MPI_DATA_ALIGNMENT>(size);
-      tags[i] = (_tags) ? _tags[i] : i+1;
-    }
+    memory::arena::lease_buffers(depth, size, buffers, tags);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+    REMOTEBUFF_PROBE(open("inout", depth));
   }
 
   /**
@@ -67,6 +71,7 @@ public: // _____________________________________________________________________
   inline void operator= (const ext::addr64 & base_address_)
   {
     base_address.ull = base_address_.ull;
+    limit = ~0ull;
     init();
     return;
   }
@@ -76,7 +81,9 @@ public: // _____________________________________________________________________
    */
   inline void operator= (const remote_block_base_iterator<T> & it)
   {
+    assert(it.writable());
     base_address.ull = it.address().ull;
+    limit = it.limit();
     init();
     return;
   }
@@ -87,8 +94,40 @@ public: // _____________________________________________________________________
   inline T* operator *()
   {
     dirty = true;
+    REMOTEBUFF_PROBE(enter());
     dma_synchronize_c(tags[current]);
-    return buffers[current].get();
+    REMOTEBUFF_PROBE(waited(current));
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(buffers[current]);
+  }
+
+  /**
+   * true if the current block has arrived, operator * does not block then;
+   * on the PPE cbe_mpi has no test, there dma_test_c waits for the block
+   */
+  inline bool ready() const
+  {
+    return dma_test_c(tags[current]);
+  }
+
+  /**
+   * pointer to the current block if it has arrived, 0 otherwise; it does
+   * not block on the SPU and the host engine but waits like ready() on the
+   * PPE; ++ still waits for the store of the buffer it loads into, so this
+   * iterator cannot be advanced without blocking
+   */
+  inline T* try_get()
+  {
+    return ready() ? **this : 0;
+  }
+
+  /**
+   * number of valid elements in the current block, smaller than the block
+   * for the final one of the data
+   */
+  inline int count()
+  {
+    int32_t addr_offset = addr_offset_calc(n-depth);
+    return (addr_offset < 0) ? 0 : clamp(addr_offset) / sizeof(T);
   }
 
   /**
@@ -97,28 +136,34 @@ public: // _____________________________________________________________________
   inline void operator ++(int)
   {
     dirty = false;
+    REMOTEBUFF_PROBE(advance());
                                 // we are finished with current buffer, store it
     int32_t addr_offset = addr_offset_calc(n-depth);
     if(addr_offset < 0)             // we don't store data if offset is negative
     {
       return;
     }
-    spe_ppe_put_async_c(base_address+(addr_offset*sizeof(T)),
-      buffers[current].get(), size, tags[current]);
+    int bytes = clamp(addr_offset);
+    spe_ppe_put_tail_async_c(base_address+(addr_offset*sizeof(T)),
+      buffers[current], bytes, tags[current]);
+    REMOTEBUFF_PROBE(put(current, bytes, n-depth));
     n++;
                         // check if we should switch a buffer from store to load
     if(n > depth+ahead)
     {
       addr_offset = addr_offset_calc(n-(ahead+1));
-      if(addr_offset < 0)        // we don't load data if the offset is negative
+      if(addr_offset >= 0)       // we don't load data if the offset is negative
       {
-        return;
-      }
                              // we load into the buffer that was stored the last
-      uint8_t current_tmp = (current + ahead + 1) % depth;
-      dma_synchronize_c(tags[current_tmp]);          // wait to finish the store
-      spe_ppe_get_async_c(buffers[current_tmp].get(), base_address+
-                          (addr_offset*sizeof(T)), size, tags[current_tmp]);
+        uint8_t current_tmp = (current + ahead + 1) % depth;
+        REMOTEBUFF_PROBE(enter());
+        dma_synchronize_c(tags[current_tmp]);        // wait to finish the store
+        REMOTEBUFF_PROBE(waited(current_tmp, false));
+        bytes = clamp(addr_offset);
+        spe_ppe_get_tail_async_c(buffers[current_tmp],
+          base_address+(addr_offset*sizeof(T)), bytes, tags[current_tmp]);
+        REMOTEBUFF_PROBE(got(current_tmp, bytes, n-(ahead+1)));
+      }
     }
     current = (current + 1) % depth;
     return;
@@ -129,16 +174,26 @@ public: // _____________________________________________________________________
     uinit();
   }
 
+#ifdef REMOTEBUFF_STATS
+  /**
+   * counters of this iterator
+   */
+  const ext::stream_stats & stats() const
+  {
+    return probe.stats();
+  }
+#endif
+
   /**
    * less than operator
    */
   bool operator <(const remote_block_base_iterator<T> b) const
   {
-           // offset that was used for data that is current after next increment
-    int32_t next_offset = addr_offset_calc(n-(ahead+1)-ahead)*sizeof(T);
+                               // offset of the current block, it may be partial
+    int32_t next_offset = addr_offset_calc(n-(ahead+1)-ahead);
     addr64 baddr = b.address();
-    if(next_offset >= 0 && baddr.ull >=
-       base_address.ull+next_offset+size)
+    if(next_offset >= 0 && baddr.ull >
+       base_address.ull+(uint64_t)next_offset*sizeof(T))
     {
       return true;
     }
@@ -150,10 +205,10 @@ public: // _____________________________________________________________________
    */
   bool operator >(const remote_block_base_iterator<T> b) const
   {
-           // offset that was used for data that is current after next increment
-    int32_t next_offset = addr_offset_calc(n-(ahead+1)-ahead)*sizeof(T);
+                               // offset of the current block, it may be partial
+    int32_t next_offset = addr_offset_calc(n-(ahead+1)-ahead);
     if(next_offset < 0 || b.address().ull <=
-       base_address.ull+next_offset+size)
+       base_address.ull+(uint64_t)next_offset*sizeof(T))
     {
       return true;
     }
@@ -162,6 +217,19 @@ public: // _____________________________________________________________________
 
  private:
 
+  /**
+   * bytes of the block at addr_offset that lie before the end of the data
+   */
+  int clamp(int32_t addr_offset) const
+  {
+    uint64_t at = base_address.ull + addr_offset*sizeof(T);
+    if(at >= limit)
+    {
+      return 0;
+    }
+    return (limit - at < (uint64_t)size) ? limit - at : size;
+  }
+
   void init()
   {
     dirty = false;
@@ -174,8 +242,10 @@ public: // _____________________________________________________________________
       {
         return;
       }
-      spe_ppe_get_async_c(buffers[i].get(),
-        base_address+(addr_offset*sizeof(T)), size, tags[i]);
+      int bytes = clamp(addr_offset);
+      spe_ppe_get_tail_async_c(buffers[i],
+        base_address+(addr_offset*sizeof(T)), bytes, tags[i]);
+      REMOTEBUFF_PROBE(got(i, bytes, n));
       n++;
     }
   }
@@ -185,20 +255,20 @@ public: // _____________________________________________________________________
     if(dirty)
     {
       int32_t addr_offset = addr_offset_calc(n-depth);
-      if(addr_offset < 0)           // we don't store data if offset is negative
+      if(addr_offset >= 0)          // we don't store data if offset is negative
       {
-        return;
+        int bytes = clamp(addr_offset);
+        spe_ppe_put_tail_async_c(base_address+(addr_offset*sizeof(T)),
+          buffers[current], bytes, tags[current]);
+        REMOTEBUFF_PROBE(put(current, bytes, n-depth));
       }
-      spe_ppe_put_async_c(base_address+(addr_offset*sizeof(T)),
-        buffers[current].get(), size, tags[current]);
+      REMOTEBUFF_PROBE(advance());
     }
 
-    for(uint8_t i=0; i<depth; i++)                               // free buffers
-    {
-      aligned_free(buffers[i]);
-    }
-    free(tags);
-    free(buffers);
+    ext::dma_tags::wait(tags, depth);          // transfers may still be running
+    REMOTEBUFF_PROBE(drain());
+    ext::dma_tags::release(owned);
+    memory::arena::release_buffers(depth, size, buffers);
   }
 
 
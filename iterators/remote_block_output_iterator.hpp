@@ -1,8 +1,13 @@
 #ifndef REMOTE_BLOCK_OUTPUT_ITERATOR_HPP_INCLUDED
 #define REMOTE_BLOCK_OUTPUT_ITERATOR_HPP_INCLUDED
 
-#include <cbe_mpi/core/memalign/aligned_ptr.hpp>
-#include <cbe_mpi/core/memalign/aligned_malloc.hpp>
+#include <assert.h>
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+#include <sdk/stats.hpp>
+#include <slicers/any_slicer.hpp>
 
 /**
  * remote block output iterator
@@ -11,7 +16,7 @@
  *
  */
 
-template<typename T>
+template<typename T, typename Slicer = any_slicer>
 class remote_block_output_iterator
 {
 
@@ -22,13 +27,18 @@ private: // ____________________________________________________________________
   uint8_t current;                        //!<  which buffer is currently in use
 
   int * tags;                             //!< tags we use for the DMA transfers
-  aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT> * buffers;                 //!< buffers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
 
   int n;                                               //!< number of iterations
   addr64 base_address;              //!< base address of the data we access
+  uint64_t limit;                    //!< end of the data, transfers stop there
                                        //! function to calculate the next access
-  boost::function<int32_t (uint32_t n)> addr_offset_calc;
+  Slicer addr_offset_calc;
   bool dirty;                   //!< indicate if the current buffer was accessed
+#ifdef REMOTEBUFF_STATS
+  ext::stream_probe probe;                              //!< counters and trace
+#endif
 
 public: // _____________________________________________________________________
 
@@ -36,19 +46,13 @@ public: // _____________________________________________________________________
    * ctor
    */
   remote_block_output_iterator(uint8_t _depth, int _size,
-    boost::function<int32_t (uint32_t n)> _addr_offset_calc, int * _tags = 0) :
-    depth(_depth), size(_size*sizeof(T)), current(0), n(0),
+    const Slicer & _addr_offset_calc, int * _tags = 0) :
+    depth(_depth), size(_size*sizeof(T)), current(0), n(0), limit(~0ull),
     addr_offset_calc(_addr_offset_calc), dirty(false)
   {
-    tags = (int*) malloc(sizeof(int) * depth);
-    buffers = (aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT> *) malloc(
-      sizeof(aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT>)*depth);
-    for(uint8_t i=0; i<depth; i++)               // allocate and initialize data
-    {
-      buffers[i] = (aligned_ptr<T, CBE_MPI_DATA_ALIGNMENT>)
-        aligned_malloc<CBE_MPI_DATA_ALIGNMENT>(size);
-      tags[i] = (_tags) ? _tags[i] : i+1;
-    }
+    memory::arena::lease_buffers(depth, size, buffers, tags);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+    REMOTEBUFF_PROBE(open("output", depth));
   }
 
   /**
@@ -58,6 +62,7 @@ public: // _____________________________________________________________________
     const ext::addr64 & base_address_)
   {
     base_address.ull = base_address_.ull;
+    limit = ~0ull;
     init();
     return *this;
   }
@@ -68,7 +73,9 @@ public: // _____________________________________________________________________
   inline remote_block_output_iterator & operator= (
     const remote_block_base_iterator<T> & it)
   {
+    assert(it.writable());
     base_address.ull = it.address().ull;
+    limit = it.limit();
     init();
     return *this;
   }
@@ -78,9 +85,40 @@ public: // _____________________________________________________________________
    */
   inline T* operator *()
   {
+    REMOTEBUFF_PROBE(enter());
     dma_synchronize_c(tags[current]);
+    REMOTEBUFF_PROBE(waited(current));
     dirty = true;
-    return buffers[current].get();
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(buffers[current]);
+  }
+
+  /**
+   * true if the store that last used the current buffer has finished,
+   * operator * does not block then; on the PPE cbe_mpi has no test, there
+   * dma_test_c waits for the store
+   */
+  inline bool ready() const
+  {
+    return dma_test_c(tags[current]);
+  }
+
+  /**
+   * pointer to the current buffer if it is free, 0 otherwise; it does not
+   * block on the SPU and the host engine but waits like ready() on the PPE
+   */
+  inline T* try_get()
+  {
+    return ready() ? **this : 0;
+  }
+
+  /**
+   * number of elements of the current block that are stored, smaller than
+   * the block for the final one of the data
+   */
+  inline int count()
+  {
+    int32_t addr_offset = addr_offset_calc(n);
+    return (addr_offset < 0) ? 0 : clamp(addr_offset) / sizeof(T);
   }
 
   /**
@@ -89,14 +127,17 @@ public: // _____________________________________________________________________
   inline void operator ++(int)
   {
     dirty = false;
+    REMOTEBUFF_PROBE(advance());
                                 // we are finished with current buffer, store it
     int32_t addr_offset = addr_offset_calc(n);
     if(addr_offset < 0)             // we don't store data if offset is negative
     {
       return;
     }
-    spe_ppe_put_async_c(base_address+(addr_offset*sizeof(T)),
-      buffers[current].get(), size, tags[current]);
+    int bytes = clamp(addr_offset);
+    spe_ppe_put_tail_async_c(base_address+(addr_offset*sizeof(T)),
+      buffers[current], bytes, tags[current]);
+    REMOTEBUFF_PROBE(put(current, bytes, n));
     n++;
     current = (current + 1) % depth;
     return;
@@ -107,16 +148,26 @@ public: // _____________________________________________________________________
     uinit();
   }
 
+#ifdef REMOTEBUFF_STATS
+  /**
+   * counters of this iterator
+   */
+  const ext::stream_stats & stats() const
+  {
+    return probe.stats();
+  }
+#endif
+
   /**
    * less than operator
    */
   bool operator <(const remote_block_base_iterator<T> b) const
   {
-           // offset that was used for data that is current after next increment
-    int32_t next_offset = addr_offset_calc(n+1)*sizeof(T);
+                               // offset of the current block, it may be partial
+    int32_t next_offset = addr_offset_calc(n);
     addr64 baddr = b.address();
     if(next_offset >= 0 && baddr.ull >
-       base_address.ull+next_offset+size)
+       base_address.ull+(uint64_t)next_offset*sizeof(T))
     {
       return true;
     }
@@ -128,10 +179,10 @@ public: // _____________________________________________________________________
    */
   bool operator >(const remote_block_base_iterator<T> b) const
   {
-           // offset that was used for data that is current after next increment
-    int32_t next_offset = addr_offset_calc(n+1)*sizeof(T);
+                               // offset of the current block, it may be partial
+    int32_t next_offset = addr_offset_calc(n);
     if(next_offset < 0 || b.address().ull <=
-       base_address.ull+next_offset+size)
+       base_address.ull+(uint64_t)next_offset*sizeof(T))
     {
       return true;
     }
@@ -140,6 +191,18 @@ public: // _____________________________________________________________________
 
  private:
 
+  /**
+   * bytes of the block at addr_offset that lie before the end of the data
+   */
+  int clamp(int32_t addr_offset) const
+  {
+    uint64_t at = base_address.ull + addr_offset*sizeof(T);
+    if(at >= limit)
+    {
+      return 0;
+    }
+    return (limit - at < (uint64_t)size) ? limit - at : size;
+  }
 
   void init()
   {
@@ -153,20 +216,19 @@ public: // _____________________________________________________________________
     if(dirty)           // store the last block because it probably was modified
     {
       int32_t addr_offset = addr_offset_calc(n);
-      if(addr_offset < 0)           // we don't store data if offset is negative
+      if(addr_offset >= 0)          // we don't store data if offset is negative
       {
-        return;
+        int bytes = clamp(addr_offset);
+        spe_ppe_put_tail_async_c(base_address+(addr_offset*sizeof(T)),
+          buffers[current], bytes, tags[current]);
+        REMOTEBUFF_PROBE(put(current, bytes, n));
       }
-      spe_ppe_put_async_c(base_address+(addr_offset*sizeof(T)),
-        buffers[current].get(), size, tags[current]);
-    }
-    for(uint8_t i=0; i<depth; i++)                               // free buffers
-    {
-      dma_synchronize_c(tags[i]);
-      aligned_free(buffers[i]);
+      REMOTEBUFF_PROBE(advance());
     }
-    free(tags);
-    free(buffers);
+    ext::dma_tags::wait(tags, depth);          // transfers may still be running
+    REMOTEBUFF_PROBE(drain());
+    ext::dma_tags::release(owned);
+    memory::arena::release_buffers(depth, size, buffers);
   }
 
 
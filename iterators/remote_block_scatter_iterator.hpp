@@ -0,0 +1,211 @@
+#ifndef REMOTE_BLOCK_SCATTER_ITERATOR_HPP_INCLUDED
+#define REMOTE_BLOCK_SCATTER_ITERATOR_HPP_INCLUDED
+
+#include <assert.h>
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+#include <slicers/list_slicer.hpp>
+
+/**
+ * remote block scatter iterator
+ *
+ * this class iterates over blocks made of several non-contiguous runs in a
+ * multi-buffering manner, a packed buffer is written and then scattered to
+ * the runs of the block with one batched transfer
+ *
+ * a block must not have more than size elements in total and every run has
+ * to lie inside the data the iterator was assigned from, both are asserted
+ *
+ */
+
+template<typename T, typename Slicer>
+class remote_block_scatter_iterator
+{
+
+private: // ____________________________________________________________________
+
+  uint8_t depth;                                 //!< the number of buffers used
+  int size;                                   //!< number of bytes in one buffer
+  uint8_t current;                        //!<  which buffer is currently in use
+
+  int * tags;                             //!< tags we use for the DMA transfers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
+  ext::dma_segment * lists;      //!< dma lists, they live until the transfer
+  segment * runs;                          //!< runs of a block from the slicer
+  int segments;                       //!< number of runs of the current block
+  int elements;                   //!< number of elements of the current block
+
+  int n;                                               //!< number of iterations
+  addr64 base_address;                   //!< base address of the data we access
+  uint64_t limit;                      //!< end of the data, runs must end there
+  Slicer slicer;                          //!< calculates the runs of a block
+  bool dirty;                   //!< indicate if the current buffer was accessed
+
+public: // _____________________________________________________________________
+
+  /**
+   * ctor
+   */
+  remote_block_scatter_iterator(uint8_t _depth, int _size,
+    const Slicer & _slicer, int * _tags = 0) :
+    depth(_depth), size(_size*sizeof(T)), current(0), segments(0),
+    elements(0), n(0), limit(~0ull), slicer(_slicer), dirty(false)
+  {
+    lists = (ext::dma_segment*) malloc(
+      sizeof(ext::dma_segment) * depth * slicer.max_segments);
+    runs = (segment*) malloc(sizeof(segment) * slicer.max_segments);
+    memory::arena::lease_buffers(depth, size, buffers, tags);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+  }
+
+  /**
+   * assignment operator (to assign to remote vector for example)
+   */
+  inline remote_block_scatter_iterator & operator= (
+    const ext::addr64 & base_address_)
+  {
+    base_address.ull = base_address_.ull;
+    limit = ~0ull;
+    init();
+    return *this;
+  }
+
+  /**
+   * assignment operator (to assign to remote vector for example)
+   */
+  inline remote_block_scatter_iterator & operator= (
+    const remote_block_base_iterator<T> & it)
+  {
+    assert(it.writable());
+    base_address.ull = it.address().ull;
+    limit = it.limit();
+    init();
+    return *this;
+  }
+
+  /**
+   * indirection operator to get a pointer to the current packed buffer
+   */
+  inline T* operator *()
+  {
+    dma_synchronize_c(tags[current]);
+    dirty = true;
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(buffers[current]);
+  }
+
+  /**
+   * number of packed elements the current block takes
+   */
+  inline int count() const
+  {
+    return elements;
+  }
+
+  /**
+   * increment operator to advance the iterator to the next block
+   */
+  inline void operator ++(int)
+  {
+    dirty = false;
+                                // we are finished with current buffer, store it
+    store();
+    n++;
+    current = (current + 1) % depth;
+    locate();
+  }
+
+  ~remote_block_scatter_iterator()
+  {
+    uinit();
+  }
+
+  /**
+   * less than operator, true while the current block exists
+   */
+  bool operator <(const remote_block_base_iterator<T>) const
+  {
+    return elements > 0;
+  }
+
+  /**
+   * greater than operator
+   */
+  bool operator >(const remote_block_base_iterator<T> b) const
+  {
+    return !(*this < b);
+  }
+
+ private:
+
+  /**
+   * build the dma list of the current block
+   */
+  void locate()
+  {
+    segments = slicer(n, runs);
+    elements = 0;
+    assert(segments <= slicer.max_segments);
+    if(segments > slicer.max_segments)
+    {
+      segments = slicer.max_segments;
+    }
+    ext::dma_segment * list = lists + current*slicer.max_segments;
+    int room = size / sizeof(T);                 // elements the buffer can take
+    for(int j=0; j<segments; j++)
+    {
+      assert(runs[j].length <= room - elements);
+      assert(base_address.ull + ((uint64_t)runs[j].offset + runs[j].length) *
+        sizeof(T) <= limit);
+      if(runs[j].length > room - elements)         // never read past the buffer
+      {
+        segments = j;
+        break;
+      }
+      list[j].offset = runs[j].offset*sizeof(T);
+      list[j].size = runs[j].length*sizeof(T);
+      elements += runs[j].length;
+    }
+  }
+
+  /**
+   * start the scatter of the current buffer
+   */
+  void store()
+  {
+    if(segments <= 0)          // we don't store data if there is no such block
+    {
+      return;
+    }
+    spe_ppe_putl_async_c(base_address, buffers[current],
+      lists + current*slicer.max_segments, segments, tags[current]);
+  }
+
+  void init()
+  {
+    current = 0;
+    n = 0;
+    dirty = false;
+    locate();
+  }
+
+  void uinit()
+  {
+    if(dirty)          // store the last block because it probably was modified
+    {
+      store();
+    }
+    ext::dma_tags::wait(tags, depth);          // transfers may still be running
+    ext::dma_tags::release(owned);
+    free(lists);
+    free(runs);
+    memory::arena::release_buffers(depth, size, buffers);
+  }
+
+
+};
+
+
+#endif // REMOTE_BLOCK_SCATTER_ITERATOR_HPP_INCLUDED
@@ -0,0 +1,197 @@
+#ifndef REMOTE_BLOCK_STENCIL_ITERATOR_HPP_INCLUDED
+#define REMOTE_BLOCK_STENCIL_ITERATOR_HPP_INCLUDED
+
+#include <string.h>
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+
+/**
+ * remote block stencil iterator
+ *
+ * this class iterates over consecutive blocks of a remote vector in a
+ * multi-buffering manner and delivers every block with halo elements on
+ * both sides, block i covers the elements [halo + i*size, halo + (i+1)*size)
+ * and p[-halo] to p[size+halo-1] are valid for p = *it
+ *
+ * the overlap between two windows is copied from the previous buffer, only
+ * size new elements are transferred per block; for a 2D stencil on a row
+ * major image use size = rows*dimX and halo = k*dimX
+ *
+ * on the Cell halo and size times sizeof(T) have to be multiples of 8 and 16
+ * bytes so the transfers of the new elements stay legal; transfers stop at
+ * the end of the data the iterator was assigned from, count() tells for how
+ * many elements of the current block both halos lie inside the data
+ *
+ */
+
+template<typename T>
+class remote_block_stencil_iterator
+{
+
+private: // ____________________________________________________________________
+
+  uint8_t depth;                                 //!< the number of buffers used
+  int size;                               //!< number of new elements per block
+  int halo;                         //!< number of neighbor elements per side
+  uint8_t current;                        //!<  which buffer is currently in use
+
+  int * tags;                             //!< tags we use for the DMA transfers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
+
+  int n;                                      //!< number of requested blocks
+  int block;                                  //!< index of the current block
+  addr64 base_address;                   //!< base address of the data we access
+  uint64_t limit;                    //!< end of the data, transfers stop there
+
+public: // _____________________________________________________________________
+
+  /**
+   * ctor
+   */
+  remote_block_stencil_iterator(uint8_t _depth, int _size, int _halo,
+    int * _tags = 0) :
+    depth(_depth), size(_size), halo(_halo), current(0), n(0), block(0),
+    limit(~0ull)
+  {
+    memory::arena::lease_buffers(depth, (size+2*halo)*sizeof(T), buffers, tags);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+  }
+
+  /**
+   * assignment operator (to assign to remote vector for example)
+   */
+  inline remote_block_stencil_iterator & operator= (
+    const ext::addr64 & base_address_)
+  {
+    base_address.ull = base_address_.ull;
+    limit = ~0ull;
+    init();
+    return *this;
+  }
+
+  /**
+   * assignment operator (to assign to remote vector for example)
+   */
+  inline remote_block_stencil_iterator & operator= (
+    const remote_block_base_iterator<T> & it)
+  {
+    base_address.ull = it.address().ull;
+    limit = it.limit();
+    init();
+    return *this;
+  }
+
+  /**
+   * indirection operator to get a pointer to the first element of the current
+   * block, the halos are in front of and behind it
+   */
+  inline T* operator *()
+  {
+    dma_synchronize_c(tags[current]);
+    return buffers[current] + halo;
+  }
+
+  /**
+   * increment operator to advance the iterator to the next block
+   */
+  inline void operator ++(int)
+  {
+    uint8_t next = (current + 1) % depth;
+                          // carry the overlap over before the buffer is reused
+    dma_synchronize_c(tags[current]);
+    memmove(buffers[next], buffers[current] + size,
+      2*halo*sizeof(T));
+    fetch(current, n);
+    n++;
+    block++;
+    current = next;
+  }
+
+  /**
+   * number of elements of the current block whose halos lie inside the
+   * data, smaller than size for the final block
+   */
+  inline int count() const
+  {
+    int bytes = clamp(base_address.ull +
+      (2*halo + (uint64_t)block*size)*sizeof(T), size*sizeof(T));
+    return bytes / sizeof(T);
+  }
+
+  ~remote_block_stencil_iterator()
+  {
+    uinit();
+  }
+
+  /**
+   * less than operator, true while the current block has an element whose
+   * halos lie in front of b, the final one may be partial
+   */
+  bool operator <(const remote_block_base_iterator<T> b) const
+  {
+    return b.address().ull >
+      base_address.ull+(2*halo + (uint64_t)block*size)*sizeof(T);
+  }
+
+  /**
+   * greater than operator
+   */
+  bool operator >(const remote_block_base_iterator<T> b) const
+  {
+    return !(*this < b);
+  }
+
+ private:
+
+  /**
+   * start the transfer of the new elements of block k into buffer i
+   */
+  void fetch(uint8_t i, int k)
+  {
+    uint64_t offset = ((uint64_t)k*size + 2*halo)*sizeof(T);
+    spe_ppe_get_tail_async_c(buffers[i] + 2*halo, base_address+offset,
+      clamp(base_address.ull + offset, size*sizeof(T)), tags[i]);
+  }
+
+  /**
+   * bytes of the bytes long range at at that lie before the end of the data
+   */
+  int clamp(uint64_t at, int bytes) const
+  {
+    if(at >= limit)
+    {
+      return 0;
+    }
+    return (limit - at < (uint64_t)bytes) ? limit - at : bytes;
+  }
+
+  void init()
+  {
+    current = 0;
+    block = 0;
+    if(halo > 0)                       // the first window is fetched entirely
+    {
+      spe_ppe_get_tail_async_c(buffers[0], base_address,
+        clamp(base_address.ull, 2*halo*sizeof(T)), tags[0]);
+    }
+    for(n=0; n<depth; n++)                                    // start transfers
+    {
+      fetch(n, n);
+    }
+  }
+
+  void uinit()
+  {
+    ext::dma_tags::wait(tags, depth);          // transfers may still be running
+    ext::dma_tags::release(owned);
+    memory::arena::release_buffers(depth, (size+2*halo)*sizeof(T), buffers);
+  }
+
+
+};
+
+
+#endif // REMOTE_BLOCK_STENCIL_ITERATOR_HPP_INCLUDED
@@ -0,0 +1,264 @@
+#ifndef REMOTE_BLOCK_ZIP_ITERATOR_HPP_INCLUDED
+#define REMOTE_BLOCK_ZIP_ITERATOR_HPP_INCLUDED
+
+#include <assert.h>
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+#include <slicers/any_slicer.hpp>
+
+/**
+ * remote block zip iterator
+ *
+ * this class advances several input and output streams together in a
+ * multi-buffering manner, block n of every stream starts at the element
+ * offset the slicer returns for n; the streams may have different element
+ * types but share the number of elements per block
+ *
+ * all transfers of one buffer slot share a tag, so a step waits once for
+ * the loads and stores of every stream:
+ *
+ *   remote_block_zip_iterator<> it(depth, size, slicer, 3);
+ *   int a = it.input(x.begin());
+ *   int b = it.input(y.begin());
+ *   int c = it.output(z.begin());
+ *   for(it.start(); it.valid(); it++)
+ *     kernel(it.get<float>(a), it.get<double>(b), it.get<float>(c), size);
+ *
+ * at most capacity streams can be added, and only before start; transfers
+ * stop at the end of the data of every stream, count(k) tells how many
+ * elements of the current block of stream k are valid
+ *
+ */
+
+template<typename Slicer = any_slicer>
+class remote_block_zip_iterator
+{
+
+private: // ____________________________________________________________________
+
+  struct stream
+  {
+    addr64 base_address;                 //!< base address of the data we access
+    uint64_t limit;                  //!< end of the data, transfers stop there
+    std::size_t elem;                               //!< size of one element
+    int bytes;                                   //!< number of bytes per block
+    int stride;                            //!< bytes from one slot to the next
+    bool output;                         //!< stored on ++ instead of loaded
+    char * buffers;                                //!< depth buffers of stream
+  };
+
+  uint8_t depth;                                 //!< the number of buffers used
+  int size;                                   //!< number of elements per block
+  uint8_t current;                        //!<  which buffer is currently in use
+
+  int * tags;                  //!< tags we use for the DMA transfers, per slot
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  stream * streams;
+  int added;                                        //!< number of streams added
+  int capacity;                               //!< maximum number of streams
+
+  int n;                                      //!< number of requested blocks
+  int block;                                  //!< index of the current block
+  Slicer addr_offset_calc;           //!< function to calculate the next access
+  bool synced;                         //!< current slot was waited for already
+  bool started;                                 //!< start was called, no adds
+
+public: // _____________________________________________________________________
+
+  /**
+   * ctor
+   */
+  remote_block_zip_iterator(uint8_t _depth, int _size,
+    const Slicer & _addr_offset_calc, int _capacity, int * _tags = 0) :
+    depth(_depth), size(_size), current(0), added(0), capacity(_capacity),
+    n(0), block(0), addr_offset_calc(_addr_offset_calc), synced(false),
+    started(false)
+  {
+    tags = (int*) memory::arena::lease(sizeof(int) * depth);
+    streams = (stream*) memory::arena::lease(sizeof(stream) * capacity);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+  }
+
+  /**
+   * add an input stream, returns its index
+   */
+  template<typename T>
+  int input(const remote_block_base_iterator<T> & it)
+  {
+    return add(it.address(), it.limit(), sizeof(T), false);
+  }
+
+  /**
+   * add an output stream, returns its index
+   */
+  template<typename T>
+  int output(const remote_block_base_iterator<T> & it)
+  {
+    assert(it.writable());
+    return add(it.address(), it.limit(), sizeof(T), true);
+  }
+
+  /**
+   * start the transfers of the first depth blocks of all input streams
+   */
+  void start()
+  {
+    current = 0;
+    block = 0;
+    synced = false;
+    started = true;
+    for(n=0; n<depth; n++)
+    {
+      fetch(n, n);
+    }
+  }
+
+  /**
+   * wait once for all transfers of the current slot
+   */
+  inline void operator *()
+  {
+    if(!synced)
+    {
+      dma_synchronize_c(tags[current]);
+      synced = true;
+    }
+  }
+
+  /**
+   * pointer to the current block of stream k
+   */
+  template<typename T>
+  inline T* get(int k)
+  {
+    **this;
+    return (T*)(streams[k].buffers + current*streams[k].stride);
+  }
+
+  /**
+   * number of valid elements in the current block of stream k, smaller than
+   * size for the final block of its data
+   */
+  inline int count(int k) const
+  {
+    int32_t addr_offset = addr_offset_calc(block);
+    return (addr_offset < 0) ? 0 :
+      clamp(streams[k], addr_offset) / streams[k].elem;
+  }
+
+  /**
+   * increment operator to advance all streams to the next block
+   */
+  inline void operator ++(int)
+  {
+    **this;                    // the outputs of the current slot are complete
+    store(current, block);
+    fetch(current, n);
+    n++;
+    block++;
+    current = (current + 1) % depth;
+    synced = false;
+  }
+
+  /**
+   * true while the slicer has a current block
+   */
+  bool valid() const
+  {
+    return addr_offset_calc(block) >= 0;
+  }
+
+  ~remote_block_zip_iterator()
+  {
+    if(synced)         // store the last block because it probably was modified
+    {
+      store(current, block);
+    }
+    ext::dma_tags::wait(tags, depth);          // transfers may still be running
+    ext::dma_tags::release(owned);
+    for(int k=0; k<added; k++)
+    {
+      memory::arena::release(streams[k].buffers, streams[k].stride * depth);
+    }
+    memory::arena::release(streams, sizeof(stream) * capacity);
+    memory::arena::release(tags, sizeof(int) * depth);
+  }
+
+ private:
+
+  int add(addr64 base_address, uint64_t limit, std::size_t elem, bool output)
+  {
+    assert(added < capacity && !started);
+    stream & s = streams[added];
+    s.base_address.ull = base_address.ull;
+    s.limit = limit;
+    s.elem = elem;
+    s.bytes = size * elem;
+    s.stride = memory::arena::align(s.bytes);
+    s.output = output;
+    s.buffers = (char*) memory::arena::lease(s.stride * depth);
+    return added++;
+  }
+
+  /**
+   * start the loads of block k of all inputs into slot i
+   */
+  void fetch(uint8_t i, int k)
+  {
+    int32_t addr_offset = addr_offset_calc(k);
+    if(addr_offset < 0)   // we don't fetch data if address offset is negative
+    {
+      return;
+    }
+    for(int j=0; j<added; j++)
+    {
+      stream & s = streams[j];
+      if(!s.output)
+      {
+        spe_ppe_get_tail_async_c(s.buffers + i*s.stride,
+          s.base_address+(addr_offset*s.elem), clamp(s, addr_offset), tags[i]);
+      }
+    }
+  }
+
+  /**
+   * start the stores of slot i of all outputs as block k
+   */
+  void store(uint8_t i, int k)
+  {
+    int32_t addr_offset = addr_offset_calc(k);
+    if(addr_offset < 0)             // we don't store data if offset is negative
+    {
+      return;
+    }
+    for(int j=0; j<added; j++)
+    {
+      stream & s = streams[j];
+      if(s.output)
+      {
+        spe_ppe_put_tail_async_c(s.base_address+(addr_offset*s.elem),
+          s.buffers + i*s.stride, clamp(s, addr_offset), tags[i]);
+      }
+    }
+  }
+
+  /**
+   * bytes of the block of s at addr_offset before the end of its data
+   */
+  static int clamp(const stream & s, int32_t addr_offset)
+  {
+    uint64_t at = s.base_address.ull + addr_offset*s.elem;
+    if(at >= s.limit)
+    {
+      return 0;
+    }
+    return (s.limit - at < (uint64_t)s.bytes) ? s.limit - at : s.bytes;
+  }
+
+
+};
+
+
+#endif // REMOTE_BLOCK_ZIP_ITERATOR_HPP_INCLUDED
@@ -0,0 +1,186 @@
+#ifndef REMOTE_TILE_INPUT_ITERATOR_HPP_INCLUDED
+#define REMOTE_TILE_INPUT_ITERATOR_HPP_INCLUDED
+
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+#include <slicers/tile_slicer.hpp>
+
+/**
+ * remote tile input iterator
+ *
+ * this class iterates over the tiles of a remote image in a multi-buffering
+ * manner, every tile is gathered row by row from the row strided image into
+ * a contiguous buffer of tileX x tileY elements (row stride tileX)
+ *
+ * on the Cell every row of a tile has to be a legal DMA transfer, so tileX
+ * and dimX times sizeof(T) should be multiples of 16 bytes; rows are
+ * clamped to the end of the data the iterator was assigned from
+ *
+ */
+
+template<typename T, typename Slicer = tile_slicer>
+class remote_tile_input_iterator
+{
+
+private: // ____________________________________________________________________
+
+  uint8_t depth;                                 //!< the number of buffers used
+  int size;                                   //!< number of bytes in one buffer
+  uint8_t current;                        //!<  which buffer is currently in use
+
+  int * tags;                             //!< tags we use for the DMA transfers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
+  tile * tiles;          //!< geometry of the tile in every buffer, leased too
+
+  int n;                                       //!< index of the current tile
+  addr64 base_address;                   //!< base address of the data we access
+  uint64_t limit;                    //!< end of the data, transfers stop there
+  Slicer slicer;                                  //!< calculates the tiles
+
+public: // _____________________________________________________________________
+
+  /**
+   * ctor
+   */
+  remote_tile_input_iterator(uint8_t _depth, const Slicer & _slicer,
+    int * _tags = 0) :
+    depth(_depth), size(_slicer.tileX*_slicer.tileY*sizeof(T)), current(0),
+    n(0), limit(~0ull), slicer(_slicer)
+  {
+    tiles = (tile*) memory::arena::lease(sizeof(tile) * depth);
+    memory::arena::lease_buffers(depth, size, buffers, tags);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+  }
+
+  /**
+   * assignment operator (to assign to remote image for example)
+   */
+  inline remote_tile_input_iterator & operator= (
+    const ext::addr64 & base_address_)
+  {
+    base_address.ull = base_address_.ull;
+    limit = ~0ull;
+    init();
+    return *this;
+  }
+
+  /**
+   * assignment operator (to assign to remote image for example)
+   */
+  inline remote_tile_input_iterator & operator= (
+    const remote_block_base_iterator<T> & it)
+  {
+    base_address.ull = it.address().ull;
+    limit = it.limit();
+    init();
+    return *this;
+  }
+
+  /**
+   * indirection operator to get a pointer to the current finished tile
+   */
+  inline T* operator *()
+  {
+    dma_synchronize_c(tags[current]);
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(buffers[current]);
+  }
+
+  /**
+   * increment operator to advance the iterator to the next tile
+   */
+  inline void operator ++(int)
+  {
+                   // we are finished with current buffer, start load of new one
+    fetch(current, n+depth);
+    n++;
+    current = (current + 1) % depth;
+  }
+
+  ~remote_tile_input_iterator()
+  {
+    uinit();
+  }
+
+  int x() const { return tiles[current].x; }        //!< column of the tile
+  int y() const { return tiles[current].y; }           //!< row of the tile
+  int width() const { return tiles[current].width; } //!< valid columns
+  int height() const { return tiles[current].height; }   //!< valid rows
+  int stride() const { return slicer.tileX; }    //!< row stride of the buffer
+
+  /**
+   * less than operator, true while the current tile exists
+   */
+  bool operator <(const remote_block_base_iterator<T> b) const
+  {
+    tile t;
+    return slicer.get(n, t) &&
+      b.address().ull > base_address.ull+t.offset*sizeof(T);
+  }
+
+  /**
+   * greater than operator
+   */
+  bool operator >(const remote_block_base_iterator<T> b) const
+  {
+    return !(*this < b);
+  }
+
+ private:
+
+  /**
+   * gather tile k into buffer i
+   */
+  void fetch(uint8_t i, uint32_t k)
+  {
+    if(!slicer.get(k, tiles[i]))
+    {
+      tiles[i].width = tiles[i].height = 0;
+      return;
+    }
+    for(int r=0; r<tiles[i].height; r++)
+    {
+      uint64_t offset = ((uint64_t)tiles[i].offset + r*slicer.dimX)*sizeof(T);
+      spe_ppe_get_tail_async_c(buffers[i] + r*slicer.tileX,
+        base_address+offset, clamp(base_address.ull + offset,
+        tiles[i].width*sizeof(T)), tags[i]);
+    }
+  }
+
+  /**
+   * bytes of the bytes long range at at that lie before the end of the data
+   */
+  int clamp(uint64_t at, int bytes) const
+  {
+    if(at >= limit)
+    {
+      return 0;
+    }
+    return (limit - at < (uint64_t)bytes) ? limit - at : bytes;
+  }
+
+  void init()
+  {
+    current = 0;
+    n = 0;
+    for(uint8_t i=0; i<depth; i++)                            // start transfers
+    {
+      fetch(i, i);
+    }
+  }
+
+  void uinit()
+  {
+    ext::dma_tags::wait(tags, depth);          // transfers may still be running
+    ext::dma_tags::release(owned);
+    memory::arena::release(tiles, sizeof(tile) * depth);
+    memory::arena::release_buffers(depth, size, buffers);
+  }
+
+
+};
+
+
+#endif // REMOTE_TILE_INPUT_ITERATOR_HPP_INCLUDED
@@ -0,0 +1,197 @@
+#ifndef REMOTE_TILE_OUTPUT_ITERATOR_HPP_INCLUDED
+#define REMOTE_TILE_OUTPUT_ITERATOR_HPP_INCLUDED
+
+#include <assert.h>
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+#include <slicers/tile_slicer.hpp>
+
+/**
+ * remote tile output iterator
+ *
+ * this class iterates over the tiles of a remote image in a multi-buffering
+ * manner, every tile is written into a contiguous buffer of tileX x tileY
+ * elements (row stride tileX) and scattered row by row into the image
+ *
+ * on the Cell every row of a tile has to be a legal DMA transfer, so tileX
+ * and dimX times sizeof(T) should be multiples of 16 bytes; rows are
+ * clamped to the end of the data the iterator was assigned from
+ *
+ */
+
+template<typename T, typename Slicer = tile_slicer>
+class remote_tile_output_iterator
+{
+
+private: // ____________________________________________________________________
+
+  uint8_t depth;                                 //!< the number of buffers used
+  int size;                                   //!< number of bytes in one buffer
+  uint8_t current;                        //!<  which buffer is currently in use
+
+  int * tags;                             //!< tags we use for the DMA transfers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  T ** buffers;                              //!< buffers, leased from the arena
+
+  int n;                                       //!< index of the current tile
+  addr64 base_address;                   //!< base address of the data we access
+  uint64_t limit;                    //!< end of the data, transfers stop there
+  Slicer slicer;                                  //!< calculates the tiles
+  tile geometry;                             //!< geometry of the current tile
+  bool dirty;                   //!< indicate if the current buffer was accessed
+
+public: // _____________________________________________________________________
+
+  /**
+   * ctor
+   */
+  remote_tile_output_iterator(uint8_t _depth, const Slicer & _slicer,
+    int * _tags = 0) :
+    depth(_depth), size(_slicer.tileX*_slicer.tileY*sizeof(T)), current(0),
+    n(0), limit(~0ull), slicer(_slicer), dirty(false)
+  {
+    memory::arena::lease_buffers(depth, size, buffers, tags);
+    owned = ext::dma_tags::acquire(tags, depth, _tags);
+  }
+
+  /**
+   * assignment operator (to assign to remote image for example)
+   */
+  inline remote_tile_output_iterator & operator= (
+    const ext::addr64 & base_address_)
+  {
+    base_address.ull = base_address_.ull;
+    limit = ~0ull;
+    init();
+    return *this;
+  }
+
+  /**
+   * assignment operator (to assign to remote image for example)
+   */
+  inline remote_tile_output_iterator & operator= (
+    const remote_block_base_iterator<T> & it)
+  {
+    assert(it.writable());
+    base_address.ull = it.address().ull;
+    limit = it.limit();
+    init();
+    return *this;
+  }
+
+  /**
+   * indirection operator to get a pointer to the current tile buffer
+   */
+  inline T* operator *()
+  {
+    dma_synchronize_c(tags[current]);
+    dirty = true;
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(buffers[current]);
+  }
+
+  /**
+   * increment operator to advance the iterator to the next tile
+   */
+  inline void operator ++(int)
+  {
+    dirty = false;
+                                // we are finished with current buffer, store it
+    store();
+    n++;
+    current = (current + 1) % depth;
+    locate();
+  }
+
+  ~remote_tile_output_iterator()
+  {
+    uinit();
+  }
+
+  int x() const { return geometry.x; }               //!< column of the tile
+  int y() const { return geometry.y; }                  //!< row of the tile
+  int width() const { return geometry.width; }          //!< valid columns
+  int height() const { return geometry.height; }           //!< valid rows
+  int stride() const { return slicer.tileX; }    //!< row stride of the buffer
+
+  /**
+   * less than operator, true while the current tile exists
+   */
+  bool operator <(const remote_block_base_iterator<T> b) const
+  {
+    return geometry.height > 0 &&
+      b.address().ull > base_address.ull+geometry.offset*sizeof(T);
+  }
+
+  /**
+   * greater than operator
+   */
+  bool operator >(const remote_block_base_iterator<T> b) const
+  {
+    return !(*this < b);
+  }
+
+ private:
+
+  /**
+   * look up the geometry of the current tile
+   */
+  void locate()
+  {
+    if(!slicer.get(n, geometry))
+    {
+      geometry.width = geometry.height = 0;
+    }
+  }
+
+  /**
+   * scatter the current buffer into the current tile
+   */
+  void store()
+  {
+    for(int r=0; r<geometry.height; r++)
+    {
+      uint64_t offset = ((uint64_t)geometry.offset + r*slicer.dimX)*sizeof(T);
+      spe_ppe_put_tail_async_c(base_address+offset,
+        buffers[current] + r*slicer.tileX, clamp(base_address.ull + offset,
+        geometry.width*sizeof(T)), tags[current]);
+    }
+  }
+
+  /**
+   * bytes of the bytes long range at at that lie before the end of the data
+   */
+  int clamp(uint64_t at, int bytes) const
+  {
+    if(at >= limit)
+    {
+      return 0;
+    }
+    return (limit - at < (uint64_t)bytes) ? limit - at : bytes;
+  }
+
+  void init()
+  {
+    current = 0;
+    n = 0;
+    dirty = false;
+    locate();
+  }
+
+  void uinit()
+  {
+    if(dirty)           // store the last tile because it probably was modified
+    {
+      store();
+    }
+    ext::dma_tags::wait(tags, depth);          // transfers may still be running
+    ext::dma_tags::release(owned);
+    memory::arena::release_buffers(depth, size, buffers);
+  }
+
+
+};
+
+
+#endif // REMOTE_TILE_OUTPUT_ITERATOR_HPP_INCLUDED
@@ -0,0 +1,226 @@
+#ifndef STATIC_REMOTE_BLOCK_OUTPUT_ITERATOR_HPP_INCLUDED
+#define STATIC_REMOTE_BLOCK_OUTPUT_ITERATOR_HPP_INCLUDED
+
+#include <assert.h>
+#include <boost/static_assert.hpp>
+#include <iterators/remote_block_base_iterator.hpp>
+#include <memory/arena.hpp>
+#include <sdk/dma.hpp>
+#include <sdk/dma_tags.hpp>
+#include <sdk/stats.hpp>
+#include <slicers/any_slicer.hpp>
+#include <iterators/static_ring.hpp>
+
+/**
+ * static remote block output iterator
+ *
+ * same as remote_block_output_iterator but depth and block size (in number of
+ * Ts) are template parameters, the buffers and tags live inside the iterator
+ * so it has to be placed on the stack or in static storage; the buffers are
+ * aligned like the ones leased from the arena
+ *
+ */
+
+template<typename T, uint8_t DEPTH, int SIZE, typename Slicer = any_slicer>
+class static_remote_block_output_iterator
+{
+
+  BOOST_STATIC_ASSERT(DEPTH >= 1);
+  BOOST_STATIC_ASSERT(SIZE > 0 && (SIZE * sizeof(T)) % 16 == 0);
+
+private: // ____________________________________________________________________
+
+  typedef static_ring<DEPTH> ring;
+
+  struct buffer
+  {
+    T data[SIZE];
+  } __attribute__((aligned(REMOTEBUFF_ARENA_ALIGNMENT)));
+
+  buffer buffers[DEPTH];                                            //!< buffers
+  int tags[DEPTH];                        //!< tags we use for the DMA transfers
+  uint32_t owned;                               //!< tags reserved from dma_tags
+  uint8_t current;                        //!<  which buffer is currently in use
+
+  int n;                                               //!< number of iterations
+  addr64 base_address;              //!< base address of the data we access
+  uint64_t limit;                    //!< end of the data, transfers stop there
+                                       //! function to calculate the next access
+  Slicer addr_offset_calc;
+  bool dirty;                   //!< indicate if the current buffer was accessed
+#ifdef REMOTEBUFF_STATS
+  ext::stream_probe probe;                              //!< counters and trace
+#endif
+
+  static const int size = SIZE * sizeof(T);   //!< number of bytes in one buffer
+
+public: // _____________________________________________________________________
+
+  /**
+   * ctor
+   */
+  static_remote_block_output_iterator(
+    const Slicer & _addr_offset_calc, int * _tags = 0) :
+    current(0), n(0), limit(~0ull), addr_offset_calc(_addr_offset_calc),
+    dirty(false)
+  {
+    owned = ext::dma_tags::acquire(tags, DEPTH, _tags);
+    REMOTEBUFF_PROBE(open("output", DEPTH));
+  }
+
+  /**
+   * assignment operator (to assign to remote vector for example)
+   */
+  inline static_remote_block_output_iterator & operator= (
+    const ext::addr64 & base_address_)
+  {
+    base_address.ull = base_address_.ull;
+    limit = ~0ull;
+    init();
+    return *this;
+  }
+
+  /**
+   * assignment operator (to assign to remote vector for example)
+   */
+  inline static_remote_block_output_iterator & operator= (
+    const remote_block_base_iterator<T> & it)
+  {
+    assert(it.writable());
+    base_address.ull = it.address().ull;
+    limit = it.limit();
+    init();
+    return *this;
+  }
+
+  /**
+   * indirection operator to get a pointer to the current finished data
+   */
+  inline T* operator *()
+  {
+    REMOTEBUFF_PROBE(enter());
+    dma_synchronize_c(tags[current]);
+    REMOTEBUFF_PROBE(waited(current));
+    dirty = true;
+    return memory::assume_aligned<REMOTEBUFF_ARENA_ALIGNMENT>(
+      buffers[current].data);
+  }
+
+  /**
+   * number of elements of the current block that are stored, smaller than
+   * the block for the final one of the data
+   */
+  inline int count()
+  {
+    int32_t addr_offset = addr_offset_calc(n);
+    return (addr_offset < 0) ? 0 : clamp(addr_offset) / sizeof(T);
+  }
+
+  /**
+   * increment operator to advance the iterator to the next block
+   */
+  inline void operator ++(int)
+  {
+    dirty = false;
+    REMOTEBUFF_PROBE(advance());
+                                // we are finished with current buffer, store it
+    int32_t addr_offset = addr_offset_calc(n);
+    if(addr_offset < 0)             // we don't store data if offset is negative
+    {
+      return;
+    }
+    int bytes = clamp(addr_offset);
+    spe_ppe_put_tail_async_c(base_address+(addr_offset*sizeof(T)),
+      buffers[current].data, bytes, tags[current]);
+    REMOTEBUFF_PROBE(put(current, bytes, n));
+    n++;
+    current = ring::next(current);
+    return;
+  }
+
+  ~static_remote_block_output_iterator()
+  {
+    if(dirty)           // store the last block because it probably was modified
+    {
+      int32_t addr_offset = addr_offset_calc(n);
+      if(addr_offset >= 0)          // we don't store data if offset is negative
+      {
+        int bytes = clamp(addr_offset);
+        spe_ppe_put_tail_async_c(base_address+(addr_offset*sizeof(T)),
+          buffers[current].data, bytes, tags[current]);
+        REMOTEBUFF_PROBE(put(current, bytes, n));
+      }
+      REMOTEBUFF_PROBE(advance());
+    }
+    ext::dma_tags::wait(tags, DEPTH);          // transfers may still be running
+    REMOTEBUFF_PROBE(drain());
+    ext::dma_tags::release(owned);
+  }
+
+#ifdef REMOTEBUFF_STATS
+  /**
+   * counters of this iterator
+   */
+  const ext::stream_stats & stats() const
+  {
+    return probe.stats();
+  }
+#endif
+
+  /**
+   * less than operator
+   */
+  bool operator <(const remote_block_base_iterator<T> b) const
+  {
+                               // offset of the current block, it may be partial
+    int32_t next_offset = addr_offset_calc(n);
+    addr64 baddr = b.address();
+    if(next_offset >= 0 && baddr.ull >
+       base_address.ull+(uint64_t)next_offset*sizeof(T))
+    {
+      return true;
+    }
+    return false;
+  }
+
+  /**
+   * greater than operator
+   */
+  bool operator >(const remote_block_base_iterator<T> b) const
+  {
+                               // offset of the current block, it may be partial
+    int32_t next_offset = addr_offset_calc(n);
+    if(next_offset < 0 || b.address().ull <=
+       base_address.ull+(uint64_t)next_offset*sizeof(T))
+    {
+      return true;
+    }
+    return false;
+  }
+
+ private:
+
+  /**
+   * bytes of the block at addr_offset that lie before the end of the data
+   */
+  int clamp(int32_t addr_offset) const
+  {
+    uint64_t at = base_address.ull + addr_offset*sizeof(T);
+    if(at >= limit)
+    {
+      return 0;
+    }
+    return (limit - at < (uint64_t)size) ? limit - at : size;
+  }
+
+  void init()
+  {
+    current = 0;
+    n = 0;
+    dirty = false;
+  }
+
+};
+
+
+#endif // STATIC_REMOTE_BLOCK_OUTPUT_ITERATOR_HPP_INCLUDED
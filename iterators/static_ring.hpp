@@ -0,0 +1,49 @@
+#ifndef STATIC_RING_HPP_INCLUDED
+#define STATIC_RING_HPP_INCLUDED
+
+#include <stdint.h>
+
+/**
+ * static ring
+ *
+ * buffer index arithmetic for a compile-time number of buffers, a power of
+ * two depth uses a mask, every other depth a compare instead of a division
+ *
+ */
+
+template<uint8_t DEPTH, bool POW2 = ((DEPTH & (DEPTH - 1)) == 0)>
+struct static_ring
+{
+  /**
+   * index of the buffer after i
+   */
+  static inline uint8_t next(uint8_t i)
+  {
+    return (i + 1) & (DEPTH - 1);
+  }
+
+  /**
+   * index of the buffer k positions after i, k has to be smaller than DEPTH
+   */
+  static inline uint8_t add(uint8_t i, uint8_t k)
+  {
+    return (i + k) & (DEPTH - 1);
+  }
+};
+
+template<uint8_t DEPTH>
+struct static_ring<DEPTH, false>
+{
+  static inline uint8_t next(uint8_t i)
+  {
+    return (i + 1 == DEPTH) ? 0 : i + 1;
+  }
+
+  static inline uint8_t add(uint8_t i, uint8_t k)
+  {
+    return (i + k >= DEPTH) ? i + k - DEPTH : i + k;
+  }
+};
+
+
+#endif // STATIC_RING_HPP_INCLUDED
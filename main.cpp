@@ -5,11 +5,12 @@
 #include <containers/local.hpp>
 #include <containers/remote.hpp>
 #include <containers/image.hpp>
+#include <containers/expression.hpp>
 
 #include <boost/spirit/include/phoenix_core.hpp>
-#include <boost/spirit/home/phoenix/function/function.hpp>
-#include <boost/spirit/home/phoenix/operator/arithmetic.hpp>
-#include <boost/spirit/home/phoenix/core/argument.hpp>
+#include <boost/phoenix/function/function.hpp>
+#include <boost/phoenix/operator/arithmetic.hpp>
+#include <boost/phoenix/core/argument.hpp>
 
 
 #include <boost/function.hpp>
@@ -22,12 +23,12 @@ int main(void)
 {
 
   printf("hi!\n");
-  local<float>::vector v(100);
-  local<float>::image i = make<float>::image(100, 100);
+  local::vector<float> v(100);
+  local::image<float> i = make<float>::image(100, 100);
 
-  remote<float>::vector vr;
+  remote::vector<float> vr;
   vr = v;
-  remote<float>::vector vr2 = v;
+  remote::vector<float> vr2 = v;
 
   float z = 13;
 
@@ -36,6 +37,13 @@ int main(void)
 
   printf("%f\n", f(1.0, 2.0, 3.0));
 
+  // the same over remote vectors, evaluated lazily in one streamed pass
+  local::vector<float> w(100);
+  remote::vector<float> vr3 = w;
+  vr3 = (vr + vr2) + z;
+
+  printf("%f\n", w[0]);
+
 }
 
 
@@ -0,0 +1,36 @@
+#ifndef ALIGNMENT_HPP_INCLUDED
+#define ALIGNMENT_HPP_INCLUDED
+
+#include <cstddef>
+
+#ifndef REMOTEBUFF_ALIGNMENT
+  #define REMOTEBUFF_ALIGNMENT 128    //!< default alignment of local data, 2^n
+#endif
+
+namespace memory
+{
+
+  /**
+   * tell the compiler p is aligned to Alignment bytes so loops over it can
+   * use aligned vector loads and stores
+   */
+  template<std::size_t Alignment, typename T>
+  inline T * assume_aligned(T * p)
+  {
+#if defined(__GNUC__) && \
+  (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 7))
+    return (T*) __builtin_assume_aligned(p, Alignment);
+#else
+    return p;
+#endif
+  }
+
+  template<typename T>
+  inline T * assume_aligned(T * p)
+  {
+    return assume_aligned<REMOTEBUFF_ALIGNMENT>(p);
+  }
+
+}
+
+#endif // ALIGNMENT_HPP_INCLUDED
@@ -3,15 +3,57 @@
 
 #include <cstddef>
 #include <stdlib.h>
+#include <memory/alignment.hpp>
+#include <memory/pages.hpp>
+
+#if __cplusplus >= 201103L
+  #include <utility>
+#endif
 
 typedef char byte;
 
 namespace memory
 {
   //////////////////////////////////////////////////////////////////////////////
-  // Allocate a raw buffer of bytes
+  // Tag to ask containers for elements that are left uninitialized (default
+  // initialized), for buffers that are overwritten by a stream anyway
+  //////////////////////////////////////////////////////////////////////////////
+  struct uninitialized_t { };
+
+  const uninitialized_t uninitialized = uninitialized_t();
+
+#if __cplusplus >= 201103L
+  //////////////////////////////////////////////////////////////////////////////
+  // While a scope is alive allocator::construct(p) default initializes on
+  // this thread, containers open one for their uninitialized_t overloads
+  // only; everywhere else elements are value initialized as usual
+  //////////////////////////////////////////////////////////////////////////////
+  class uninitialized_scope
+  {
+    bool previous;
+
+    uninitialized_scope(const uninitialized_scope &);          // not copyable
+    uninitialized_scope & operator=(const uninitialized_scope &);
+
+  public:
+
+    uninitialized_scope() : previous(active()) { active() = true; }
+    ~uninitialized_scope() { active() = previous; }
+
+    static bool & active()
+    {
+      static thread_local bool a = false;
+      return a;
+    }
+  };
+#endif
+
+  //////////////////////////////////////////////////////////////////////////////
+  // Allocate a raw buffer of bytes aligned to Alignment (a power of two),
+  // large buffers can be backed by huge pages on request, see pages.hpp
   //////////////////////////////////////////////////////////////////////////////
-  template<class T> struct allocator
+  template<class T, std::size_t Alignment = REMOTEBUFF_ALIGNMENT>
+  struct allocator
   {
     ////////////////////////////////////////////////////////////////////////////
     // Internal typedefs
@@ -24,13 +66,15 @@ namespace memory
     typedef std::size_t size_type;
     typedef std::ptrdiff_t difference_type;
 
-    template<class U> struct rebind { typedef allocator<U> other; };
+    template<class U> struct rebind { typedef allocator<U, Alignment> other; };
+
+    enum { alignment = Alignment };
 
     ////////////////////////////////////////////////////////////////////////////
     // Ctor/dtor
     ////////////////////////////////////////////////////////////////////////////
                       allocator() {}
-    template<class U> allocator(allocator<U> const& ) {}
+    template<class U> allocator(allocator<U, Alignment> const& ) {}
                      ~allocator() {}
 
     allocator& operator=(allocator const& ) { return *this; }
@@ -54,6 +98,27 @@ namespace memory
       p = new (p) value_type(t);
     }
 
+#if __cplusplus >= 201103L
+    // value initialization, default initialization inside an
+    // uninitialized_scope
+    template<class U> void construct(U* p)
+    {
+      if(uninitialized_scope::active())
+      {
+        ::new((void*)p) U;
+      }
+      else
+      {
+        ::new((void*)p) U();
+      }
+    }
+
+    template<class U, class... Args> void construct(U* p, Args&&... args)
+    {
+      ::new((void*)p) U(std::forward<Args>(args)...);
+    }
+#endif
+
     void destroy(pointer p) { p->~value_type(); }
 
     ////////////////////////////////////////////////////////////////////////////
@@ -62,20 +127,54 @@ namespace memory
     pointer allocate( size_type c, const void* = 0 ) const
     {
       void* ptr = 0;
+      size_type bytes = c*sizeof(value_type);
+#ifdef REMOTEBUFF_MAPPED_PAGES
+      if(pages::wanted(bytes, Alignment))
+      {
+        return reinterpret_cast<pointer>(pages::map(bytes));
+      }
+#endif
 #ifndef __SPU__
-      posix_memalign(&ptr, 16, c*sizeof(value_type));
+      if(posix_memalign(&ptr, Alignment < sizeof(void*) ?
+                        sizeof(void*) : Alignment, bytes) != 0)
+      {
+        ptr = 0;
+      }
 #else
-      ptr = _malloc_align(c*sizeof(value_type), 7);
+      ptr = _malloc_align(bytes, __builtin_ctz(Alignment));
 #endif
       return reinterpret_cast<pointer>(ptr);
     }
 
-    void deallocate(pointer p, size_type) const
+    void deallocate(pointer p, size_type c) const
     {
+#ifdef REMOTEBUFF_MAPPED_PAGES
+      if(p && pages::wanted(c*sizeof(value_type), Alignment))
+      {
+        pages::unmap(p, c*sizeof(value_type));
+        return;
+      }
+#endif
+#ifndef __SPU__
       free(p);
+#else
+      _free_align(p);
+#endif
     }
 
   };
+
+  template<class T, class U, std::size_t A>
+  inline bool operator==(allocator<T, A> const&, allocator<U, A> const&)
+  {
+    return true;
+  }
+
+  template<class T, class U, std::size_t A>
+  inline bool operator!=(allocator<T, A> const&, allocator<U, A> const&)
+  {
+    return false;
+  }
 }
 
 #endif // ALLOCATOR_HPP_INCLUDED
@@ -0,0 +1,295 @@
+#ifndef ARENA_HPP_INCLUDED
+#define ARENA_HPP_INCLUDED
+
+#include <cstddef>
+#include <new>
+#include <stdlib.h>
+#include <stdint.h>
+#include <sdk/dma.hpp>
+#include <memory/alignment.hpp>
+
+#ifdef REMOTEBUFF_HOST_DMA
+  #include <pthread.h>
+#endif
+
+#ifndef REMOTEBUFF_ARENA_ALIGNMENT
+  #define REMOTEBUFF_ARENA_ALIGNMENT REMOTEBUFF_ALIGNMENT  //!< leased blocks
+#endif
+
+#ifndef REMOTEBUFF_ARENA_CACHE
+  #define REMOTEBUFF_ARENA_CACHE 8    //!< released blocks kept per size class
+#endif
+
+namespace memory
+{
+
+  /**
+   * @brief pool of aligned, reusable blocks
+   *
+   * blocks are handed out in power of two size classes, released blocks go
+   * to a free list of the releasing thread and are leased again from there
+   * without locking; iterators that are built for every kernel call lease
+   * their buffers, pointer and tag arrays as one block:
+   *
+   *   memory::arena::lease_buffers(depth, bytes, buffers, tags);
+   *   ...
+   *   memory::arena::release_buffers(depth, bytes, buffers);
+   *
+   */
+  class arena
+  {
+
+  private: // __________________________________________________________________
+
+    enum { classes = 24 };          //!< size classes, larger blocks bypass
+
+    struct node
+    {
+      node * next;
+    };
+
+    struct pool
+    {
+      node * free[classes];                  //!< released blocks per class
+      int count[classes];
+
+      pool()
+      {
+        for(int c=0; c<classes; c++)
+        {
+          free[c] = 0;
+          count[c] = 0;
+        }
+      }
+
+      ~pool()
+      {
+        for(int c=0; c<classes; c++)
+        {
+          while(free[c])
+          {
+            node * n = free[c];
+            free[c] = n->next;
+            deallocate(n);
+          }
+        }
+      }
+    };
+
+  public: // ___________________________________________________________________
+
+    /**
+     * lease a block of at least bytes bytes, throws std::bad_alloc like new
+     * if there is no memory left
+     */
+    static void * lease(std::size_t bytes)
+    {
+      int c = size_class(bytes);
+      if(c >= classes)
+      {
+        return checked(allocate(bytes));
+      }
+      pool * p = local();
+      node * n = p->free[c];
+      if(!n)
+      {
+        return checked(allocate(capacity(c)));
+      }
+      p->free[c] = n->next;
+      p->count[c]--;
+      return n;
+    }
+
+    /**
+     * hand a block back, bytes is the size it was leased with
+     */
+    static void release(void * block, std::size_t bytes)
+    {
+      if(!block)
+      {
+        return;
+      }
+      int c = size_class(bytes);
+      pool * p = (c < classes) ? local() : 0;
+      if(!p || p->count[c] >= REMOTEBUFF_ARENA_CACHE)
+      {
+        deallocate(block);
+        return;
+      }
+      node * n = (node*) block;
+      n->next = p->free[c];
+      p->free[c] = n;
+      p->count[c]++;
+    }
+
+    /**
+     * lease depth buffers of bytes bytes each together with the arrays that
+     * hold their pointers and tags, buffers[0] is the start of the block
+     */
+    template<typename T>
+    static void lease_buffers(uint8_t depth, std::size_t bytes,
+      T **& buffers, int *& tags)
+    {
+      std::size_t stride = align(bytes);
+      char * block = (char*) lease(footprint<T>(depth, bytes));
+      buffers = (T**)(block + depth*stride);
+      tags = (int*)(buffers + depth);
+      for(uint8_t i=0; i<depth; i++)
+      {
+        buffers[i] = (T*)(block + i*stride);
+      }
+    }
+
+    /**
+     * hand back buffers leased with lease_buffers
+     */
+    template<typename T>
+    static void release_buffers(uint8_t depth, std::size_t bytes, T ** buffers)
+    {
+      release(buffers[0], footprint<T>(depth, bytes));
+    }
+
+    /**
+     * bytes rounded up to the alignment
+     */
+    static std::size_t align(std::size_t bytes)
+    {
+      return (bytes + REMOTEBUFF_ARENA_ALIGNMENT - 1) &
+        ~(std::size_t)(REMOTEBUFF_ARENA_ALIGNMENT - 1);
+    }
+
+  private: // __________________________________________________________________
+
+    static void * checked(void * block)
+    {
+      if(!block)
+      {
+        throw std::bad_alloc();
+      }
+      return block;
+    }
+
+    template<typename T>
+    static std::size_t footprint(uint8_t depth, std::size_t bytes)
+    {
+      return depth * (align(bytes) + sizeof(T*) + sizeof(int));
+    }
+
+    static std::size_t capacity(int c)
+    {
+      return (std::size_t)REMOTEBUFF_ARENA_ALIGNMENT << c;
+    }
+
+    static int size_class(std::size_t bytes)
+    {
+      int c = 0;
+      while(c < classes && capacity(c) < bytes)
+      {
+        c++;
+      }
+      return c;
+    }
+
+    static void * allocate(std::size_t bytes)
+    {
+      void * ptr = 0;
+#ifndef __SPU__
+      std::size_t alignment = REMOTEBUFF_ARENA_ALIGNMENT;
+      if(bytes >= 4096 && alignment < 4096)    // page aligned for O_DIRECT
+      {
+        alignment = 4096;
+      }
+      if(posix_memalign(&ptr, alignment, bytes) != 0)
+      {
+        ptr = 0;
+      }
+#else
+      ptr = _malloc_align(bytes, __builtin_ctz(REMOTEBUFF_ARENA_ALIGNMENT));
+#endif
+      return ptr;
+    }
+
+    static void deallocate(void * ptr)
+    {
+#ifndef __SPU__
+      ::free(ptr);
+#else
+      _free_align(ptr);
+#endif
+    }
+
+#ifdef REMOTEBUFF_HOST_DMA
+
+    /**
+     * pool of the calling thread, created on first use
+     */
+    static pool * local()
+    {
+      pool *& p = slot();
+      if(!p)
+      {
+        pthread_once(&key_once(), &make_key);
+        p = new pool();
+        pthread_setspecific(key(), p);
+      }
+      return p;
+    }
+
+    static pool *& slot()
+    {
+      static __thread pool * p = 0;
+      return p;
+    }
+
+    static pthread_once_t & key_once()
+    {
+      static pthread_once_t once = PTHREAD_ONCE_INIT;
+      return once;
+    }
+
+    static pthread_key_t & key()
+    {
+      static pthread_key_t k;
+      return k;
+    }
+
+    static void make_key()
+    {
+      pthread_key_create(&key(), &free_pool);
+      atexit(&free_main_pool);
+    }
+
+    /**
+     * the key destructor does not run for the thread that calls exit
+     */
+    static void free_main_pool()
+    {
+      pool * p = slot();
+      if(p)
+      {
+        pthread_setspecific(key(), 0);
+        free_pool(p);
+      }
+    }
+
+    static void free_pool(void * p)
+    {
+      slot() = 0;
+      delete (pool*) p;
+    }
+
+#else
+
+    static pool * local()
+    {
+      static pool p;
+      return &p;
+    }
+
+#endif
+
+  };
+
+}
+
+#endif // ARENA_HPP_INCLUDED
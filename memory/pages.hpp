@@ -0,0 +1,139 @@
+#ifndef PAGES_HPP_INCLUDED
+#define PAGES_HPP_INCLUDED
+
+#include <cstddef>
+
+/**
+ * page backed allocations
+ *
+ * large local buffers are streamed through once per pass, with 4K pages every
+ * few blocks cost a TLB miss; allocations of REMOTEBUFF_HUGE_THRESHOLD bytes
+ * and more can therefore be mapped directly and backed by huge pages:
+ *
+ *   REMOTEBUFF_HUGE_PAGES 0   never, always go through the heap, the default
+ *   REMOTEBUFF_HUGE_PAGES 1   transparent huge pages (madvise)
+ *   REMOTEBUFF_HUGE_PAGES 2   explicit huge pages (MAP_HUGETLB), falls back
+ *                             to transparent ones if the pool is empty
+ *
+ * with REMOTEBUFF_NUMA_LOCAL the pages are placed on the NUMA node of the
+ * allocating thread instead of the node that touches them first
+ *
+ */
+
+#ifndef REMOTEBUFF_HUGE_PAGES
+  #define REMOTEBUFF_HUGE_PAGES 0
+#endif
+
+#ifndef REMOTEBUFF_HUGE_THRESHOLD
+  #define REMOTEBUFF_HUGE_THRESHOLD (4*1024*1024)   //!< smaller use the heap
+#endif
+
+#if defined(__linux__) && !defined(__SPU__) && REMOTEBUFF_HUGE_PAGES
+  #define REMOTEBUFF_MAPPED_PAGES
+#endif
+
+#ifdef REMOTEBUFF_MAPPED_PAGES
+
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace memory
+{
+
+  /**
+   * @brief maps and unmaps page backed memory
+   */
+  struct pages
+  {
+    enum { huge = 2*1024*1024 };                     //!< size of a huge page
+
+    /**
+     * true if an allocation of bytes bytes should be mapped
+     */
+    static bool wanted(std::size_t bytes, std::size_t alignment)
+    {
+      return bytes >= REMOTEBUFF_HUGE_THRESHOLD && alignment <= 4096;
+    }
+
+    /**
+     * map bytes bytes, returns 0 on failure
+     */
+    static void * map(std::size_t bytes)
+    {
+      bytes = round(bytes);
+      void * p = MAP_FAILED;
+#if REMOTEBUFF_HUGE_PAGES == 2 && defined(MAP_HUGETLB)
+      p = mmap(0, bytes, PROT_READ | PROT_WRITE,
+        MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+#endif
+      if(p == MAP_FAILED)
+      {
+        p = mmap(0, bytes + huge, PROT_READ | PROT_WRITE,
+          MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(p == MAP_FAILED)
+        {
+          return 0;
+        }
+        p = trim((char*) p, bytes);       // huge pages need aligned ranges
+#ifdef MADV_HUGEPAGE
+        madvise(p, bytes, MADV_HUGEPAGE);
+#endif
+      }
+#ifdef REMOTEBUFF_NUMA_LOCAL
+      local(p, bytes);
+#endif
+      return p;
+    }
+
+    static void unmap(void * p, std::size_t bytes)
+    {
+      munmap(p, round(bytes));
+    }
+
+  private:
+
+    /**
+     * unmap the parts of a mapping of bytes + huge bytes outside of the huge
+     * page aligned range of bytes bytes inside it
+     */
+    static void * trim(char * p, std::size_t bytes)
+    {
+      std::size_t head = (huge - ((std::size_t)p & (huge - 1))) & (huge - 1);
+      if(head)
+      {
+        munmap(p, head);
+      }
+      munmap(p + head + bytes, huge - head);
+      return p + head;
+    }
+
+    static std::size_t round(std::size_t bytes)
+    {
+      return (bytes + huge - 1) & ~(std::size_t)(huge - 1);
+    }
+
+#ifdef REMOTEBUFF_NUMA_LOCAL
+    /**
+     * prefer the node of the calling thread for the pages of p
+     */
+    static void local(void * p, std::size_t bytes)
+    {
+      unsigned cpu = 0, node = 0;
+      if(syscall(SYS_getcpu, &cpu, &node, 0) != 0 || node >= 64)
+      {
+        return;
+      }
+      unsigned long mask = 1ul << node;
+      const int preferred = 1;                           // MPOL_PREFERRED
+      syscall(SYS_mbind, p, bytes, preferred, &mask, 64, 0);
+    }
+#endif
+
+  };
+
+}
+
+#endif // REMOTEBUFF_MAPPED_PAGES
+
+#endif // PAGES_HPP_INCLUDED
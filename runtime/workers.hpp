@@ -0,0 +1,239 @@
+#ifndef WORKERS_HPP_INCLUDED
+#define WORKERS_HPP_INCLUDED
+
+#include <sdk/dma.hpp>
+
+/**
+ * worker runtime
+ *
+ * on the Cell every SPE is a worker and SPE_Rank() and SPE_Size() come from
+ * cbe_mpi; on the host a pool of threads takes their place, every thread
+ * has its own rank and its own DMA tags, so slicers like vector_slicer
+ * partition the data over all cores unchanged:
+ *
+ *   ext::workers::run(kernel);        // kernel() runs once on every core
+ *
+ * the function object is shared by all workers, workers::reduce combines a
+ * partial result of every worker in a tree
+ *
+ */
+
+#ifdef REMOTEBUFF_HOST_DMA
+
+#include <pthread.h>
+#include <unistd.h>
+
+namespace ext
+{
+
+  /**
+   * @brief rank and size of the calling worker
+   */
+  struct worker_context
+  {
+    int rank;
+    int size;
+    pthread_barrier_t * barrier;               //!< shared by all workers
+    void ** slots;                    //!< partials published by reduce, by rank
+  };
+
+  /**
+   * @brief launches and joins a group of workers
+   */
+  class workers
+  {
+
+  private: // __________________________________________________________________
+
+    /**
+     * holds the workers back until all of them were started
+     */
+    struct start_gate
+    {
+      pthread_mutex_t lock;
+      pthread_cond_t opened;
+      int state;                              //!< 0 closed, 1 run, -1 cancelled
+    };
+
+    template<typename F>
+    struct launch
+    {
+      F * f;
+      worker_context context;
+      start_gate * gate;
+    };
+
+  public: // ___________________________________________________________________
+
+    /**
+     * run f() on count workers (one per core for 0) and wait for all of them,
+     * the calling thread is worker 0; returns 0 or the error of pthread_create
+     * if not all workers could be started, f() then runs on none of them
+     */
+    template<typename F>
+    static int run(F f, int count = 0)
+    {
+      if(count <= 0)
+      {
+        count = cores();
+      }
+      pthread_barrier_t barrier;
+      pthread_barrier_init(&barrier, 0, count);
+      start_gate gate;
+      pthread_mutex_init(&gate.lock, 0);
+      pthread_cond_init(&gate.opened, 0);
+      gate.state = 0;
+      launch<F> * launches = new launch<F>[count];
+      pthread_t * threads = new pthread_t[count];
+      void ** slots = new void*[count];
+      for(int i=0; i<count; i++)
+      {
+        launches[i].f = &f;
+        launches[i].context.rank = i;
+        launches[i].context.size = count;
+        launches[i].context.barrier = &barrier;
+        launches[i].context.slots = slots;
+        launches[i].gate = &gate;
+      }
+      int error = 0;
+      int started = 1;
+      for(; started<count; started++)
+      {
+        error = pthread_create(&threads[started], 0, &entry<F>,
+          &launches[started]);
+        if(error != 0)           // the others would wait for it at the barriers
+        {
+          break;
+        }
+      }
+      pthread_mutex_lock(&gate.lock);
+      gate.state = error ? -1 : 1;
+      pthread_cond_broadcast(&gate.opened);
+      pthread_mutex_unlock(&gate.lock);
+      entry<F>(&launches[0]);
+      for(int i=1; i<started; i++)
+      {
+        pthread_join(threads[i], 0);
+      }
+      delete [] slots;
+      delete [] threads;
+      delete [] launches;
+      pthread_cond_destroy(&gate.opened);
+      pthread_mutex_destroy(&gate.lock);
+      pthread_barrier_destroy(&barrier);
+      return error;
+    }
+
+    /**
+     * wait until all workers of the group reached the barrier
+     */
+    static void barrier()
+    {
+      if(current())
+      {
+        pthread_barrier_wait(current()->barrier);
+      }
+    }
+
+    /**
+     * combine the partial of every worker with op.combine(a, b) in a tree of
+     * log2(size) steps, all workers return the result; every worker of the
+     * group has to call it
+     */
+    template<typename R, typename Op>
+    static R reduce(const R & partial, const Op & op)
+    {
+      if(!current())
+      {
+        return partial;
+      }
+      R value = partial;
+      int r = rank();
+      int n = size();
+      current()->slots[r] = &value;
+      for(int step=1; step<n; step*=2)
+      {
+        barrier();                            // the last step is finished
+        if(r % (2*step) == 0 && r + step < n)
+        {
+          value = op.combine(value, *(const R*)current()->slots[r + step]);
+        }
+      }
+      barrier();
+      R result = *(const R*)current()->slots[0];
+      barrier();                   // rank 0 keeps value until everyone read it
+      return result;
+    }
+
+    static int rank()
+    {
+      return current() ? current()->rank : 0;
+    }
+
+    static int size()
+    {
+      return current() ? current()->size : 1;
+    }
+
+    static int cores()
+    {
+      long n = sysconf(_SC_NPROCESSORS_ONLN);
+      return (n > 0) ? (int) n : 1;
+    }
+
+  private: // __________________________________________________________________
+
+    /**
+     * context of the calling thread, 0 outside of run
+     */
+    static worker_context *& current()
+    {
+      static __thread worker_context * context = 0;
+      return context;
+    }
+
+    template<typename F>
+    static void * entry(void * arg)
+    {
+      launch<F> * l = (launch<F>*) arg;
+      pthread_mutex_lock(&l->gate->lock);
+      while(l->gate->state == 0)
+      {
+        pthread_cond_wait(&l->gate->opened, &l->gate->lock);
+      }
+      bool cancelled = (l->gate->state < 0);
+      pthread_mutex_unlock(&l->gate->lock);
+      if(cancelled)
+      {
+        return 0;
+      }
+      worker_context * outer = current();
+      current() = &l->context;
+      (*l->f)();
+      current() = outer;
+      return 0;
+    }
+
+  };
+
+}
+
+/**
+ * rank of the calling worker, 0 outside of workers::run
+ */
+inline int SPE_Rank()
+{
+  return ext::workers::rank();
+}
+
+/**
+ * number of workers, 1 outside of workers::run
+ */
+inline int SPE_Size()
+{
+  return ext::workers::size();
+}
+
+#endif // REMOTEBUFF_HOST_DMA
+
+#endif // WORKERS_HPP_INCLUDED
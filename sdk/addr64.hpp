@@ -73,6 +73,17 @@ namespace ext
     }
 #endif
 
-  };
+  };
 }
+
+/**
+ * the iterators name the address type addr64: on the Cell it is the one of
+ * the cbe_mpi SDK whose transfer calls take it, elsewhere ext::addr64
+ */
+#ifdef CBE_MPI_CELL_SPE_SUPPORT
+  #include <cbe_mpi/sdk/addr64.hpp>
+#else
+using ext::addr64;
+#endif
+
 #endif // ADDR64_HPP_INCLUDED
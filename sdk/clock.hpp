@@ -0,0 +1,53 @@
+#ifndef CLOCK_HPP_INCLUDED
+#define CLOCK_HPP_INCLUDED
+
+#include <stdint.h>
+
+#ifdef __SPU__
+  #include <spu_intrinsics.h>
+#else
+  #include <time.h>
+#endif
+
+#ifndef REMOTEBUFF_TIMEBASE
+  #define REMOTEBUFF_TIMEBASE 79800000        //!< SPU decrementer frequency
+#endif
+
+namespace ext
+{
+
+  /**
+   * @brief monotonic time stamps for measuring transfers and compute
+   *
+   * on the SPU the decrementer is used, it has to be started by the
+   * application, everywhere else the monotonic clock in nanoseconds
+   *
+   */
+  struct clock
+  {
+    typedef uint64_t ticks;
+
+    static inline ticks now()
+    {
+#ifdef __SPU__
+      return 0xFFFFFFFFu - spu_read_decrementer();
+#else
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return (ticks)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+#endif
+    }
+
+    static inline double seconds(ticks t)
+    {
+#ifdef __SPU__
+      return (double)t / REMOTEBUFF_TIMEBASE;
+#else
+      return (double)t * 1e-9;
+#endif
+    }
+  };
+
+}
+
+#endif // CLOCK_HPP_INCLUDED
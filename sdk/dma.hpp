@@ -0,0 +1,616 @@
+#ifndef DMA_HPP_INCLUDED
+#define DMA_HPP_INCLUDED
+
+#include <stdint.h>
+
+/**
+ * dma backend selection
+ *
+ * on the Cell the transfer functions spe_ppe_get_async_c, spe_ppe_put_async_c
+ * and dma_synchronize_c come from the cbe_mpi SDK; everywhere else they are
+ * served by the host dma engine below
+ *
+ */
+
+#if !defined(__SPU__) && !defined(CBE_MPI_CELL_SPE_SUPPORT)
+  #define REMOTEBUFF_HOST_DMA
+#endif
+
+namespace ext
+{
+
+  /**
+   * @brief one element of a dma list
+   *
+   * size bytes at offset bytes from the effective base address, the segments
+   * of a list are packed back to back in local memory
+   *
+   */
+  struct dma_segment
+  {
+    int32_t offset;
+    uint32_t size;
+  };
+
+}
+
+#ifdef REMOTEBUFF_HOST_DMA
+
+#include <assert.h>
+#include <pthread.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef REMOTEBUFF_DMA_THREADS
+  #define REMOTEBUFF_DMA_THREADS 0     //!< number of copy threads, 0 per core
+#endif
+
+#ifndef REMOTEBUFF_DMA_CHUNK
+  #define REMOTEBUFF_DMA_CHUNK (64*1024)    //!< transfers are split into chunks
+#endif
+
+#ifndef REMOTEBUFF_DMA_INLINE
+  #define REMOTEBUFF_DMA_INLINE 256         //!< smaller transfers copy inline
+#endif
+
+#define REMOTEBUFF_DMA_TAGS 32              //!< tags per thread, like the MFC
+
+namespace ext
+{
+
+  /**
+   * @brief tag groups of one issuing thread
+   *
+   * every thread that issues transfers gets its own table, just like every SPE
+   * has its own MFC, so waiting on a tag never waits for another thread
+   *
+   */
+  struct dma_tag_table
+  {
+    pthread_mutex_t lock;
+    pthread_cond_t done;
+    int pending[REMOTEBUFF_DMA_TAGS];   //!< outstanding chunks per tag
+
+    dma_tag_table()
+    {
+      pthread_mutex_init(&lock, 0);
+      pthread_cond_init(&done, 0);
+      memset(pending, 0, sizeof(pending));
+    }
+
+    ~dma_tag_table()
+    {
+      pthread_cond_destroy(&done);
+      pthread_mutex_destroy(&lock);
+    }
+  };
+
+  /**
+   * @brief one queued chunk of a transfer
+   */
+  struct dma_request
+  {
+    void * dst;
+    const void * src;
+    uint32_t size;
+    int tag;
+    dma_tag_table * table;
+    dma_request * next;
+  };
+
+  /**
+   * @brief host dma engine
+   *
+   * a pool of copy threads that serves tagged asynchronous transfers, the
+   * memcpy runs in the background while the issuing thread computes
+   *
+   */
+  class dma_engine
+  {
+
+  private: // __________________________________________________________________
+
+    pthread_mutex_t lock;
+    pthread_cond_t work;
+    dma_request * head;                               //!< queue of open chunks
+    dma_request * tail;
+    dma_request * free_list;                    //!< recycled request nodes
+    pthread_t * threads;
+    int nthreads;                                  //!< number of copy threads
+    bool stop;
+
+  public: // ___________________________________________________________________
+
+    static dma_engine & instance()
+    {
+      static dma_engine engine;
+      return engine;
+    }
+
+    /**
+     * issue an asynchronous copy of size bytes under tag
+     */
+    void issue(void * dst, const void * src, uint32_t size, int tag)
+    {
+      dma_segment segment;
+      segment.offset = 0;
+      segment.size = size;
+      issue_list(dst, src, &segment, 1, tag, true);
+    }
+
+    /**
+     * issue a batch of copies between the packed local buffer ls and the
+     * segments at ea under one tag, get copies from ea to ls and put back
+     */
+    void issue_list(void * ls, const void * ea, const dma_segment * list,
+      int count, int tag, bool get)
+    {
+      assert(tag >= 0 && tag < REMOTEBUFF_DMA_TAGS);
+      uint32_t chunks = 0;
+      uint32_t packed = 0;
+      for(int i=0; i<count; i++)
+      {
+        char * local = (char*)ls + packed;
+        char * remote = (char*)ea + list[i].offset;
+        packed += list[i].size;
+        if(list[i].size <= REMOTEBUFF_DMA_INLINE)   // not worth a hand over
+        {
+          memcpy(get ? local : remote, get ? remote : local, list[i].size);
+          continue;
+        }
+        chunks += (list[i].size + REMOTEBUFF_DMA_CHUNK - 1) /
+          REMOTEBUFF_DMA_CHUNK;
+      }
+      if(chunks == 0)
+      {
+        return;
+      }
+
+      dma_tag_table * table = tags();
+      pthread_mutex_lock(&table->lock);
+      table->pending[tag] += chunks;
+      pthread_mutex_unlock(&table->lock);
+
+      pthread_mutex_lock(&lock);
+      packed = 0;
+      for(int i=0; i<count; i++)
+      {
+        char * local = (char*)ls + packed;
+        char * remote = (char*)ea + list[i].offset;
+        uint32_t size = list[i].size;
+        packed += size;
+        if(size <= REMOTEBUFF_DMA_INLINE)
+        {
+          continue;
+        }
+        for(uint32_t offset=0; offset<size; offset+=REMOTEBUFF_DMA_CHUNK)
+        {
+          dma_request * r = acquire();
+          r->dst = (get ? local : remote) + offset;
+          r->src = (get ? remote : local) + offset;
+          r->size = (size - offset < REMOTEBUFF_DMA_CHUNK) ?
+            size - offset : REMOTEBUFF_DMA_CHUNK;
+          r->tag = tag;
+          r->table = table;
+          r->next = 0;
+          if(tail)
+          {
+            tail->next = r;
+          }
+          else
+          {
+            head = r;
+          }
+          tail = r;
+        }
+      }
+      pthread_cond_broadcast(&work);
+      pthread_mutex_unlock(&lock);
+    }
+
+    /**
+     * block until all transfers of the calling thread under tag are finished
+     */
+    void wait(int tag)
+    {
+      assert(tag >= 0 && tag < REMOTEBUFF_DMA_TAGS);
+      dma_tag_table * table = tags();
+      pthread_mutex_lock(&table->lock);
+      while(table->pending[tag] != 0)
+      {
+        pthread_cond_wait(&table->done, &table->lock);
+      }
+      pthread_mutex_unlock(&table->lock);
+    }
+
+    /**
+     * true if all transfers of the calling thread under tag are finished,
+     * never blocks
+     */
+    bool done(int tag)
+    {
+      assert(tag >= 0 && tag < REMOTEBUFF_DMA_TAGS);
+      dma_tag_table * table = tags();
+      pthread_mutex_lock(&table->lock);
+      bool finished = (table->pending[tag] == 0);
+      pthread_mutex_unlock(&table->lock);
+      return finished;
+    }
+
+    /**
+     * wait until all transfers of the calling thread under the tags in mask
+     * are finished
+     */
+    void wait_mask(uint32_t mask)
+    {
+      dma_tag_table * table = tags();
+      pthread_mutex_lock(&table->lock);
+      for(int tag=0; tag<REMOTEBUFF_DMA_TAGS; tag++)
+      {
+        while((mask & (1u << tag)) && table->pending[tag] != 0)
+        {
+          pthread_cond_wait(&table->done, &table->lock);
+        }
+      }
+      pthread_mutex_unlock(&table->lock);
+    }
+
+    /**
+     * tag table of the calling thread, created on first use
+     */
+    static dma_tag_table * tags()
+    {
+      static __thread dma_tag_table * table = 0;
+      if(!table)
+      {
+        pthread_once(&key_once(), &make_key);
+        table = new dma_tag_table();
+        pthread_setspecific(key(), table);
+      }
+      return table;
+    }
+
+  private: // __________________________________________________________________
+
+    dma_engine() : head(0), tail(0), free_list(0), stop(false)
+    {
+      pthread_mutex_init(&lock, 0);
+      pthread_cond_init(&work, 0);
+      nthreads = REMOTEBUFF_DMA_THREADS;
+      if(nthreads <= 0)          // workers on every core need copy threads too
+      {
+        nthreads = (int) sysconf(_SC_NPROCESSORS_ONLN);
+        nthreads = (nthreads < 2) ? 2 : nthreads;
+      }
+      threads = new pthread_t[nthreads];
+      for(int i=0; i<nthreads; i++)
+      {
+        pthread_create(&threads[i], 0, &run, this);
+      }
+    }
+
+    ~dma_engine()
+    {
+      pthread_mutex_lock(&lock);
+      stop = true;
+      pthread_cond_broadcast(&work);
+      pthread_mutex_unlock(&lock);
+      for(int i=0; i<nthreads; i++)
+      {
+        pthread_join(threads[i], 0);
+      }
+      delete [] threads;
+      while(free_list)
+      {
+        dma_request * r = free_list;
+        free_list = r->next;
+        delete r;
+      }
+      pthread_cond_destroy(&work);
+      pthread_mutex_destroy(&lock);
+    }
+
+    dma_request * acquire()                                // lock must be held
+    {
+      if(!free_list)
+      {
+        return new dma_request();
+      }
+      dma_request * r = free_list;
+      free_list = r->next;
+      return r;
+    }
+
+    static void * run(void * arg)
+    {
+      dma_engine * self = (dma_engine*) arg;
+      pthread_mutex_lock(&self->lock);
+      while(true)
+      {
+        while(!self->head && !self->stop)
+        {
+          pthread_cond_wait(&self->work, &self->lock);
+        }
+        if(!self->head)                                // stopped and drained
+        {
+          break;
+        }
+        dma_request * r = self->head;
+        self->head = r->next;
+        if(!self->head)
+        {
+          self->tail = 0;
+        }
+        pthread_mutex_unlock(&self->lock);
+
+        memcpy(r->dst, r->src, r->size);
+
+        dma_tag_table * table = r->table;
+        pthread_mutex_lock(&table->lock);
+        if(--table->pending[r->tag] == 0)
+        {
+          pthread_cond_broadcast(&table->done);
+        }
+        pthread_mutex_unlock(&table->lock);
+
+        pthread_mutex_lock(&self->lock);
+        r->next = self->free_list;
+        self->free_list = r;
+      }
+      pthread_mutex_unlock(&self->lock);
+      return 0;
+    }
+
+    static pthread_once_t & key_once()
+    {
+      static pthread_once_t once = PTHREAD_ONCE_INIT;
+      return once;
+    }
+
+    static pthread_key_t & key()
+    {
+      static pthread_key_t k;
+      return k;
+    }
+
+    static void make_key()
+    {
+      pthread_key_create(&key(), &free_table);
+    }
+
+    /**
+     * the copy threads may still hold transfers of an exiting thread that
+     * never waited for them, drain those before the table goes away
+     */
+    static void free_table(void * table)
+    {
+      dma_tag_table * t = (dma_tag_table*) table;
+      pthread_mutex_lock(&t->lock);
+      for(int tag=0; tag<REMOTEBUFF_DMA_TAGS; tag++)
+      {
+        while(t->pending[tag] != 0)
+        {
+          pthread_cond_wait(&t->done, &t->lock);
+        }
+      }
+      pthread_mutex_unlock(&t->lock);
+      delete t;
+    }
+
+  };
+
+}
+
+/**
+ * start an asynchronous get from effective address ea into local memory
+ *
+ * the address type is a template so both ext::addr64 and cbe_mpi::addr64 can
+ * be passed as they are
+ */
+template<typename A>
+inline void spe_ppe_get_async_c(void * ls, const A & ea, int size, int tag)
+{
+  ext::dma_engine::instance().issue(ls, (const void*)(uintptr_t)ea.ull,
+    size, tag);
+}
+
+/**
+ * start an asynchronous put from local memory to effective address ea
+ */
+template<typename A>
+inline void spe_ppe_put_async_c(const A & ea, const void * ls, int size,
+  int tag)
+{
+  ext::dma_engine::instance().issue((void*)(uintptr_t)ea.ull, ls, size, tag);
+}
+
+/**
+ * wait until all transfers of this thread under tag are finished
+ */
+inline void dma_synchronize_c(int tag)
+{
+  ext::dma_engine::instance().wait(tag);
+}
+
+/**
+ * wait until all transfers of this thread under the tags in mask are finished
+ */
+inline void dma_synchronize_mask_c(uint32_t mask)
+{
+  ext::dma_engine::instance().wait_mask(mask);
+}
+
+/**
+ * true if all transfers of this thread under tag are finished, never blocks
+ */
+inline bool dma_test_c(int tag)
+{
+  return ext::dma_engine::instance().done(tag);
+}
+
+/**
+ * start an asynchronous gather of count segments at ea into local memory,
+ * all segments are transferred as one batch under tag
+ */
+template<typename A>
+inline void spe_ppe_getl_async_c(void * ls, const A & ea,
+  const ext::dma_segment * list, int count, int tag)
+{
+  ext::dma_engine::instance().issue_list(ls, (const void*)(uintptr_t)ea.ull,
+    list, count, tag, true);
+}
+
+/**
+ * start an asynchronous scatter of local memory to count segments at ea
+ */
+template<typename A>
+inline void spe_ppe_putl_async_c(const A & ea, const void * ls,
+  const ext::dma_segment * list, int count, int tag)
+{
+  ext::dma_engine::instance().issue_list((void*)ls,
+    (const void*)(uintptr_t)ea.ull, list, count, tag, false);
+}
+
+#else // REMOTEBUFF_HOST_DMA
+
+#ifdef __SPU__
+  #include <spu_mfcio.h>
+#endif
+
+/**
+ * wait until all transfers under the tags in mask are finished
+ */
+inline void dma_synchronize_mask_c(uint32_t mask)
+{
+#ifdef __SPU__
+  mfc_write_tag_mask(mask);
+  mfc_read_tag_status_all();
+#else
+  for(int tag=0; tag<32; tag++)
+  {
+    if(mask & (1u << tag))
+    {
+      dma_synchronize_c(tag);
+    }
+  }
+#endif
+}
+
+/**
+ * true if all transfers under tag are finished
+ *
+ * the SPU polls its tag status without blocking, cbe_mpi has no test on the
+ * PPE so there it waits and always returns true
+ */
+inline bool dma_test_c(int tag)
+{
+#ifdef __SPU__
+  mfc_write_tag_mask(1u << tag);
+  return mfc_read_tag_status_immediate() != 0;
+#else
+  dma_synchronize_c(tag);
+  return true;
+#endif
+}
+
+/**
+ * gather on the Cell, one transfer per segment under the same tag
+ */
+template<typename A>
+inline void spe_ppe_getl_async_c(void * ls, const A & ea,
+  const ext::dma_segment * list, int count, int tag)
+{
+  char * local = (char*) ls;
+  for(int i=0; i<count; i++)
+  {
+    spe_ppe_get_async_c(local, ea+list[i].offset, list[i].size, tag);
+    local += list[i].size;
+  }
+}
+
+/**
+ * scatter on the Cell, one transfer per segment under the same tag
+ */
+template<typename A>
+inline void spe_ppe_putl_async_c(const A & ea, const void * ls,
+  const ext::dma_segment * list, int count, int tag)
+{
+  const char * local = (const char*) ls;
+  for(int i=0; i<count; i++)
+  {
+    spe_ppe_put_async_c(ea+list[i].offset, (void*)local, list[i].size, tag);
+    local += list[i].size;
+  }
+}
+
+#endif // REMOTEBUFF_HOST_DMA
+
+namespace ext
+{
+
+  /**
+   * split a transfer of bytes bytes into DMA legal segments: the multiple of
+   * 16 bytes first, then the rest in naturally aligned pieces of 8, 4, 2 and
+   * 1 bytes; returns the number of segments, at most 5
+   */
+  inline int dma_split(uint32_t bytes, dma_segment * list)
+  {
+    int count = 0;
+    uint32_t offset = bytes & ~15u;
+    if(offset)
+    {
+      list[count].offset = 0;
+      list[count++].size = offset;
+    }
+    for(uint32_t piece=8; piece>0; piece>>=1)
+    {
+      if(bytes & piece)
+      {
+        list[count].offset = offset;
+        list[count++].size = piece;
+        offset += piece;
+      }
+    }
+    return count;
+  }
+
+}
+
+/**
+ * start an asynchronous get of any length, a length that is no multiple of 16
+ * (the final block of the data) is split with dma_split, 0 does nothing
+ */
+template<typename A>
+inline void spe_ppe_get_tail_async_c(void * ls, const A & ea, int size,
+  int tag)
+{
+  if(size & 15)
+  {
+    ext::dma_segment list[5];
+    spe_ppe_getl_async_c(ls, ea, list, ext::dma_split(size, list), tag);
+  }
+  else if(size > 0)
+  {
+    spe_ppe_get_async_c(ls, ea, size, tag);
+  }
+}
+
+/**
+ * start an asynchronous put of any length, see spe_ppe_get_tail_async_c
+ */
+template<typename A>
+inline void spe_ppe_put_tail_async_c(const A & ea, const void * ls, int size,
+  int tag)
+{
+  if(size & 15)
+  {
+    ext::dma_segment list[5];
+    spe_ppe_putl_async_c(ea, ls, list, ext::dma_split(size, list), tag);
+  }
+  else if(size > 0)
+  {
+    spe_ppe_put_async_c(ea, ls, size, tag);
+  }
+}
+
+#endif // DMA_HPP_INCLUDED
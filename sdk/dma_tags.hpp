@@ -0,0 +1,119 @@
+#ifndef DMA_TAGS_HPP_INCLUDED
+#define DMA_TAGS_HPP_INCLUDED
+
+#include <assert.h>
+#include <stdint.h>
+#include <sdk/dma.hpp>
+
+#ifndef REMOTEBUFF_RESERVED_TAGS
+  #define REMOTEBUFF_RESERVED_TAGS 0x1u    //!< tags never handed out, tag 0
+#endif
+
+namespace ext
+{
+
+  /**
+   * @brief hands out disjoint DMA tags to the iterators of one thread
+   *
+   * tags belong to the issuing thread (the MFC of an SPE, the tag table of a
+   * host thread), so the free tags are a per thread mask; iterators that are
+   * alive at the same time get different tags and never wait for each
+   * other's transfers
+   *
+   * if there are not enough free tags the iterator falls back to 1..depth
+   * like before, which is correct but synchronizes it with other streams
+   *
+   */
+  class dma_tags
+  {
+
+  public: // ___________________________________________________________________
+
+    enum { count = 32 };                          //!< tags per issuing thread
+
+    /**
+     * fill tags with given if there are any, otherwise with depth free tags;
+     * returns the mask of the tags that were reserved and must be released,
+     * given tags have to lie in [0, count)
+     */
+    static uint32_t acquire(int * tags, int depth, const int * given = 0)
+    {
+      if(given)
+      {
+        for(int i=0; i<depth; i++)
+        {
+          assert(given[i] >= 0 && given[i] < count);
+          tags[i] = given[i];
+        }
+        return 0;
+      }
+      uint32_t & used = in_use();
+      uint32_t mask = 0;
+      int found = 0;
+      for(int tag=0; tag<count && found<depth; tag++)
+      {
+        if(!(used & (1u << tag)))
+        {
+          tags[found++] = tag;
+          mask |= 1u << tag;
+        }
+      }
+      if(found < depth)                           // shared fallback, see above
+      {
+        for(int i=0; i<depth; i++)
+        {
+          tags[i] = (i % (count-1)) + 1;
+        }
+        return 0;
+      }
+      used |= mask;
+      return mask;
+    }
+
+    /**
+     * give back the tags acquire reserved
+     */
+    static void release(uint32_t mask)
+    {
+      in_use() &= ~mask;
+    }
+
+    /**
+     * mask of a group of tags
+     */
+    static uint32_t mask(const int * tags, int depth)
+    {
+      uint32_t m = 0;
+      for(int i=0; i<depth; i++)
+      {
+        assert(tags[i] >= 0 && tags[i] < count);
+        m |= 1u << tags[i];
+      }
+      return m;
+    }
+
+    /**
+     * wait once for all transfers of a group of tags
+     */
+    static void wait(const int * tags, int depth)
+    {
+      dma_synchronize_mask_c(mask(tags, depth));
+    }
+
+  private: // __________________________________________________________________
+
+    static uint32_t & in_use()
+    {
+#ifdef REMOTEBUFF_HOST_DMA
+      static __thread uint32_t used = REMOTEBUFF_RESERVED_TAGS;
+#else
+      static uint32_t used = REMOTEBUFF_RESERVED_TAGS;
+#endif
+      return used;
+    }
+
+  };
+
+}
+
+#endif // DMA_TAGS_HPP_INCLUDED
@@ -0,0 +1,135 @@
+#ifndef SIMD_HPP_INCLUDED
+#define SIMD_HPP_INCLUDED
+
+#include <stdint.h>
+
+#ifndef REMOTEBUFF_VECTOR_BYTES
+  #if defined(__AVX512F__)
+    #define REMOTEBUFF_VECTOR_BYTES 64                 //!< width of the kernels
+  #elif defined(__AVX__)
+    #define REMOTEBUFF_VECTOR_BYTES 32
+  #else
+    #define REMOTEBUFF_VECTOR_BYTES 16                 //!< SSE, AltiVec and SPU
+  #endif
+#endif
+
+#if !defined(__SPU__) && \
+  (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 8))
+  #define REMOTEBUFF_VECTOR_SELECT            //!< a < b ? a : b on vector types
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && \
+  (__GNUC__ > 4 || (__GNUC__ == 4 && __GNUC_MINOR__ >= 9)) && \
+  !defined(REMOTEBUFF_NO_DISPATCH)
+  #define REMOTEBUFF_SIMD_DISPATCH         //!< pick AVX2 or AVX-512 at run time
+#endif
+
+#define REMOTEBUFF_ALWAYS_INLINE inline __attribute__((always_inline))
+
+namespace ext
+{
+
+  /**
+   * @brief GCC vector type of Bytes bytes for the element type T
+   *
+   * the blocks operator * returns are aligned to REMOTEBUFF_ARENA_ALIGNMENT,
+   * so the kernels load whole vectors from them and finish the rest of a
+   * partial block element by element
+   *
+   */
+  template<typename T, int Bytes = REMOTEBUFF_VECTOR_BYTES>
+  struct simd
+  {
+    typedef T type __attribute__((vector_size(Bytes), may_alias));
+    enum { lanes = Bytes / sizeof(T) };
+
+    union lanes_of
+    {
+      type v;
+      T e[lanes];
+    };
+  };
+
+  /**
+   * @brief integer type with the size of T, for shuffle masks
+   */
+  template<int Size> struct lane_index { };
+  template<> struct lane_index<4> { typedef int32_t type; };
+  template<> struct lane_index<8> { typedef int64_t type; };
+
+  /**
+   * @brief runs a kernel at the widest vector width of the running CPU
+   *
+   * a kernel K has an always inline template<int Bytes> void run() const;
+   * run is instantiated once for the compile time width, once inside a
+   * function compiled for AVX2 and once for AVX-512F, and the first call
+   * checks which of them the CPU supports; without REMOTEBUFF_SIMD_DISPATCH
+   * (not x86, old compilers) only the compile time width is used
+   *
+   */
+  class simd_dispatch
+  {
+
+  public: // ___________________________________________________________________
+
+    enum level { baseline, avx2, avx512 };
+
+    template<typename K>
+    static void run(const K & k)
+    {
+#ifdef REMOTEBUFF_SIMD_DISPATCH
+      switch(detected())
+      {
+        case avx512: run_avx512(k); return;
+        case avx2: run_avx2(k); return;
+        default: break;
+      }
+#endif
+      k.template run<REMOTEBUFF_VECTOR_BYTES>();
+    }
+
+    static level detected()
+    {
+      static level l = detect();
+      return l;
+    }
+
+  private: // __________________________________________________________________
+
+    static level detect()
+    {
+#ifdef REMOTEBUFF_SIMD_DISPATCH
+      __builtin_cpu_init();
+      if(__builtin_cpu_supports("avx512f") && REMOTEBUFF_VECTOR_BYTES < 64)
+      {
+        return avx512;
+      }
+      if(__builtin_cpu_supports("avx2") && REMOTEBUFF_VECTOR_BYTES < 32)
+      {
+        return avx2;
+      }
+#endif
+      return baseline;
+    }
+
+#ifdef REMOTEBUFF_SIMD_DISPATCH
+    template<typename K>
+    __attribute__((target("avx2,fma"), noinline))
+    static void run_avx2(const K & k)
+    {
+      k.template run<32>();
+    }
+
+    template<typename K>
+    __attribute__((target("avx512f"), noinline))
+    static void run_avx512(const K & k)
+    {
+      k.template run<64>();
+    }
+#endif
+
+  };
+
+}
+
+#endif // SIMD_HPP_INCLUDED
@@ -0,0 +1,318 @@
+#ifndef STATS_HPP_INCLUDED
+#define STATS_HPP_INCLUDED
+
+/**
+ * optional instrumentation of the block iterators
+ *
+ * compiled in with -DREMOTEBUFF_STATS, without it REMOTEBUFF_PROBE expands to
+ * nothing and the iterators carry no extra state or code
+ *
+ */
+#ifdef REMOTEBUFF_STATS
+  #define REMOTEBUFF_PROBE(call) probe.call
+#else
+  #define REMOTEBUFF_PROBE(call)
+#endif
+
+#ifdef REMOTEBUFF_STATS
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sdk/clock.hpp>
+
+#ifndef REMOTEBUFF_TRACE_EVENTS
+  #ifdef __SPU__
+    #define REMOTEBUFF_TRACE_EVENTS 256           //!< events kept by ext::trace
+  #else
+    #define REMOTEBUFF_TRACE_EVENTS 65536         //!< events kept by ext::trace
+  #endif
+#endif
+
+#ifndef REMOTEBUFF_TRACE_STREAMS
+  #define REMOTEBUFF_TRACE_STREAMS 256          //!< streams ext::trace can name
+#endif
+
+namespace ext
+{
+
+  /**
+   * @brief counters of one stream
+   */
+  struct stream_stats
+  {
+    uint64_t bytes_got;                          //!< bytes transferred to local
+    uint64_t bytes_put;                         //!< bytes transferred to remote
+    uint32_t transfers;                                    //!< transfers issued
+    uint32_t blocks;                         //!< blocks handed out and advanced
+    clock::ticks stalled;                   //!< time spent in dma_synchronize_c
+  };
+
+  /**
+   * @brief process wide log of per block events
+   *
+   * events are get, put (issue until the iterator saw the transfer finish,
+   * so an upper bound of the transfer time), wait (time the iterator stalled)
+   * and compute (operator * returned until ++); the log keeps the first
+   * REMOTEBUFF_TRACE_EVENTS events and write exports it as Chrome trace JSON
+   * (chrome://tracing, Perfetto) with one row per stream
+   *
+   */
+  class trace
+  {
+
+  public: // ___________________________________________________________________
+
+    struct event
+    {
+      const char * name;
+      uint32_t stream;
+      uint32_t block;
+      clock::ticks begin;
+      clock::ticks end;
+    };
+
+    /**
+     * register a stream, kind names its row in the trace
+     */
+    static uint32_t stream(const char * kind)
+    {
+      uint32_t id = __sync_fetch_and_add(&log().streams, 1);
+      if(id < REMOTEBUFF_TRACE_STREAMS)
+      {
+        log().kinds[id] = kind;
+      }
+      return id;
+    }
+
+    static void record(const char * name, uint32_t stream, uint32_t block,
+      clock::ticks begin, clock::ticks end)
+    {
+      uint32_t i = __sync_fetch_and_add(&log().count, 1);
+      if(i < REMOTEBUFF_TRACE_EVENTS)
+      {
+        event & e = log().events[i];
+        e.name = name;
+        e.stream = stream;
+        e.block = block;
+        e.begin = begin;
+        e.end = end;
+      }
+    }
+
+    /**
+     * number of events recorded, including the ones that did not fit
+     */
+    static uint32_t size()
+    {
+      return log().count;
+    }
+
+    static void clear()
+    {
+      log().count = 0;
+    }
+
+    /**
+     * write the events to path, must not race with record
+     */
+    static bool write(const char * path)
+    {
+      FILE * f = fopen(path, "w");
+      if(!f)
+      {
+        return false;
+      }
+      state & s = log();
+      uint32_t count = (s.count < REMOTEBUFF_TRACE_EVENTS) ?
+        s.count : REMOTEBUFF_TRACE_EVENTS;
+      uint32_t streams = (s.streams < REMOTEBUFF_TRACE_STREAMS) ?
+        s.streams : REMOTEBUFF_TRACE_STREAMS;
+      clock::ticks origin = 0;
+      for(uint32_t i=0; i<count; i++)
+      {
+        if(i == 0 || s.events[i].begin < origin)
+        {
+          origin = s.events[i].begin;
+        }
+      }
+
+      fprintf(f, "{\"traceEvents\":[\n");
+      const char * sep = "";
+      for(uint32_t i=0; i<streams; i++)              // one named row per stream
+      {
+        fprintf(f, "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+          "\"tid\":%u,\"args\":{\"name\":\"%s %u\"}}", sep, i, s.kinds[i], i);
+        sep = ",\n";
+      }
+      for(uint32_t i=0; i<count; i++)
+      {
+        const event & e = s.events[i];
+        fprintf(f, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,"
+          "\"ts\":%.3f,\"dur\":%.3f,\"args\":{\"block\":%u}}", sep, e.name,
+          e.stream, clock::seconds(e.begin - origin) * 1e6,
+          clock::seconds(e.end - e.begin) * 1e6, e.block);
+        sep = ",\n";
+      }
+      fprintf(f, "\n]}\n");
+      return fclose(f) == 0;
+    }
+
+  private: // __________________________________________________________________
+
+    struct state
+    {
+      volatile uint32_t count;
+      volatile uint32_t streams;
+      event events[REMOTEBUFF_TRACE_EVENTS];
+      const char * kinds[REMOTEBUFF_TRACE_STREAMS];
+    };
+
+    static state & log()
+    {
+      static state s;
+      return s;
+    }
+
+  };
+
+  /**
+   * @brief counters and trace state of one iterator
+   *
+   * the iterators call it through REMOTEBUFF_PROBE: open once the depth is
+   * known, got and put when a transfer is issued into buffer slot, enter and
+   * waited around dma_synchronize_c on slot (handing is false if the block
+   * is not handed out afterwards), advance on ++ and drain after the final
+   * wait
+   *
+   */
+  class stream_probe
+  {
+
+  private: // __________________________________________________________________
+
+    stream_stats counters;
+    uint32_t id;                                        //!< stream in the trace
+    int depth;
+    clock::ticks * issued;          //!< issue time per slot, 0 if not in flight
+    const char ** kind;                           //!< get or put, for each slot
+    uint32_t * block;                      //!< block transferred, for each slot
+    clock::ticks entered;                          //!< dma_synchronize_c called
+    clock::ticks handed;                           //!< operator * returned or 0
+
+    stream_probe(const stream_probe &);                          // not copyable
+    stream_probe & operator=(const stream_probe &);
+
+  public: // ___________________________________________________________________
+
+    stream_probe() : id(0), depth(0), issued(0), kind(0), block(0) { }
+
+    void open(const char * name, int depth_)
+    {
+      counters.bytes_got = counters.bytes_put = 0;
+      counters.transfers = counters.blocks = 0;
+      counters.stalled = 0;
+      id = trace::stream(name);
+      depth = depth_;
+      issued = (clock::ticks *)calloc(depth, sizeof(clock::ticks));
+      kind = (const char **)calloc(depth, sizeof(const char *));
+      block = (uint32_t *)calloc(depth, sizeof(uint32_t));
+      entered = handed = 0;
+    }
+
+    ~stream_probe()
+    {
+      free(issued);
+      free(kind);
+      free(block);
+    }
+
+    const stream_stats & stats() const
+    {
+      return counters;
+    }
+
+    void got(int slot, int bytes, uint32_t n)
+    {
+      if(bytes == 0)                             // clamped away at the data end
+      {
+        return;
+      }
+      counters.bytes_got += bytes;
+      issue(slot, "get", n);
+    }
+
+    void put(int slot, int bytes, uint32_t n)
+    {
+      if(bytes == 0)                             // clamped away at the data end
+      {
+        return;
+      }
+      counters.bytes_put += bytes;
+      issue(slot, "put", n);
+    }
+
+    void enter()
+    {
+      entered = clock::now();
+    }
+
+    void waited(int slot, bool handing = true)
+    {
+      clock::ticks now = clock::now();
+      counters.stalled += now - entered;
+      if(issued[slot])                // the transfer is known to be done by now
+      {
+        trace::record(kind[slot], id, block[slot], issued[slot], now);
+        trace::record("wait", id, counters.blocks, entered, now);
+        issued[slot] = 0;
+      }
+      if(handing)
+      {
+        handed = now;
+      }
+    }
+
+    void advance()
+    {
+      if(handed)
+      {
+        trace::record("compute", id, counters.blocks, handed, clock::now());
+        handed = 0;
+      }
+      counters.blocks++;
+    }
+
+    void drain()
+    {
+      clock::ticks now = clock::now();
+      for(int i=0; i<depth; i++)
+      {
+        if(issued[i])
+        {
+          trace::record(kind[i], id, block[i], issued[i], now);
+          issued[i] = 0;
+        }
+      }
+    }
+
+  private:
+
+    void issue(int slot, const char * name, uint32_t n)
+    {
+      counters.transfers++;
+      if(!issued[slot])                     // an earlier transfer is still open
+      {
+        issued[slot] = clock::now();
+        kind[slot] = name;
+        block[slot] = n;
+      }
+    }
+
+  };
+
+}
+
+#endif // REMOTEBUFF_STATS
+
+#endif // STATS_HPP_INCLUDED
@@ -0,0 +1,500 @@
+#ifndef URING_HPP_INCLUDED
+#define URING_HPP_INCLUDED
+
+#include <cstddef>
+#include <stdint.h>
+
+/**
+ * asynchronous file transfers
+ *
+ * the file block iterators read and write file offsets the way the other
+ * iterators get and put effective addresses: a transfer is started under a
+ * tag and later waited for by tag; on Linux the transfers go through an
+ * io_uring per thread, one submission per block, elsewhere (or if the kernel
+ * refuses a ring) they are done synchronously with pread and pwrite; short
+ * transfers are continued until they are complete, a read stops early only
+ * at the end of the file
+ *
+ * the ring is driven with raw system calls, there is no liburing dependency;
+ * reads and writes need IORING_OP_READ and IORING_OP_WRITE (Linux 5.6)
+ *
+ */
+
+#if defined(__linux__) && !defined(__SPU__)
+  #include <sys/syscall.h>
+  #if defined(__NR_io_uring_setup) && !defined(REMOTEBUFF_NO_URING)
+    #define REMOTEBUFF_URING
+  #endif
+#endif
+
+#ifndef __SPU__
+
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#ifdef REMOTEBUFF_URING
+  #include <linux/io_uring.h>
+  #include <sys/mman.h>
+#endif
+
+#ifndef REMOTEBUFF_URING_ENTRIES
+  #define REMOTEBUFF_URING_ENTRIES 64        //!< transfers in flight per thread
+#endif
+
+namespace ext
+{
+
+  /**
+   * @brief file transfer queue of one thread
+   */
+  class uring
+  {
+
+  private: // __________________________________________________________________
+
+    enum { tags = 32 };                          //!< same tag space as dma_tags
+
+    int fd;                                        //!< the ring, -1 without one
+    unsigned inflight;                             //!< submitted, not completed
+    int pending[tags];                          //!< submitted transfers per tag
+    int64_t status[tags];                      //!< first error per tag or bytes
+
+#ifdef REMOTEBUFF_URING
+    struct request                      //!< a transfer in flight, for the retry
+    {
+      int op;
+      int file;
+      char * buf;
+      unsigned bytes;
+      uint64_t offset;
+      int tag;
+    };
+
+    request requests[REMOTEBUFF_URING_ENTRIES];
+    int free_requests[REMOTEBUFF_URING_ENTRIES];            //!< unused requests
+    int free_count;
+    unsigned * sq_head;
+    unsigned * sq_tail;
+    unsigned * sq_mask;
+    unsigned * sq_array;
+    unsigned sq_entries;
+    io_uring_sqe * sqes;
+    unsigned * cq_head;
+    unsigned * cq_tail;
+    unsigned * cq_mask;
+    io_uring_cqe * cqes;
+    void * sq_ring;
+    void * cq_ring;
+    std::size_t sq_ring_size;
+    std::size_t cq_ring_size;
+#endif
+
+  public: // ___________________________________________________________________
+
+    /**
+     * start reading bytes bytes at offset of file into buf under tag
+     */
+    void read(int file, void * buf, unsigned bytes, uint64_t offset, int tag)
+    {
+#ifdef REMOTEBUFF_URING
+      if(fd >= 0)
+      {
+        submit(IORING_OP_READ, file, buf, bytes, offset, tag);
+        return;
+      }
+#endif
+      done(tag, complete(false, file, (char*)buf, bytes, offset));
+    }
+
+    /**
+     * start writing bytes bytes of buf at offset of file under tag
+     */
+    void write(int file, const void * buf, unsigned bytes, uint64_t offset,
+      int tag)
+    {
+#ifdef REMOTEBUFF_URING
+      if(fd >= 0)
+      {
+        submit(IORING_OP_WRITE, file, (void*)buf, bytes, offset, tag);
+        return;
+      }
+#endif
+      done(tag, complete(true, file, (char*)buf, bytes, offset));
+    }
+
+    /**
+     * wait for all transfers under tag, returns the bytes they transferred
+     * since the last wait or the first error as -errno
+     */
+    int64_t wait(int tag)
+    {
+#ifdef REMOTEBUFF_URING
+      while(pending[tag] > 0)
+      {
+        reap(true);
+      }
+#endif
+      int64_t result = status[tag];
+      status[tag] = 0;
+      return result;
+    }
+
+    /**
+     * true if transfers are asynchronous
+     */
+    bool asynchronous() const
+    {
+      return fd >= 0;
+    }
+
+    /**
+     * queue of the calling thread, created on first use
+     */
+    static uring & local()
+    {
+      uring *& u = slot();
+      if(!u)
+      {
+        pthread_once(&key_once(), &make_key);
+        u = new uring();
+        pthread_setspecific(key(), u);
+      }
+      return *u;
+    }
+
+  private: // __________________________________________________________________
+
+    uring() : fd(-1), inflight(0)
+    {
+      memset(pending, 0, sizeof(pending));
+      memset(status, 0, sizeof(status));
+#ifdef REMOTEBUFF_URING
+      free_count = REMOTEBUFF_URING_ENTRIES;
+      for(int i=0; i<free_count; i++)
+      {
+        free_requests[i] = i;
+      }
+      setup();
+#endif
+    }
+
+    ~uring()
+    {
+#ifdef REMOTEBUFF_URING
+      while(inflight > 0)
+      {
+        reap(true);
+      }
+      if(fd >= 0)
+      {
+        munmap(sqes, sq_entries * sizeof(io_uring_sqe));
+        munmap(cq_ring, cq_ring_size);
+        munmap(sq_ring, sq_ring_size);
+        close(fd);
+      }
+#endif
+    }
+
+    /**
+     * synchronous transfer, repeated until all bytes are moved, an error
+     * occurs or a read hits the end of the file
+     */
+    static int64_t complete(bool writing, int file, char * buf,
+      unsigned bytes, uint64_t offset)
+    {
+      int64_t total = 0;
+      while(bytes > 0)
+      {
+        ssize_t r = writing ? pwrite(file, buf, bytes, offset) :
+                              pread(file, buf, bytes, offset);
+        if(r < 0 && errno == EINTR)
+        {
+          continue;
+        }
+        if(r < 0)
+        {
+          return -errno;
+        }
+        if(r == 0)
+        {
+          return writing ? -EIO : total;           // a write must make progress
+        }
+        total += r;
+        buf += r;
+        bytes -= r;
+        offset += r;
+      }
+      return total;
+    }
+
+    void done(int tag, int64_t result)
+    {
+      if(result < 0 && status[tag] >= 0)
+      {
+        status[tag] = (result == -1) ? -errno : result;
+      }
+      else if(status[tag] >= 0)
+      {
+        status[tag] += result;
+      }
+    }
+
+#ifdef REMOTEBUFF_URING
+
+    void setup()
+    {
+      io_uring_params p;
+      memset(&p, 0, sizeof(p));
+      int ring = syscall(__NR_io_uring_setup, REMOTEBUFF_URING_ENTRIES, &p);
+      if(ring < 0)
+      {
+        return;
+      }
+      sq_ring_size = p.sq_off.array + p.sq_entries * sizeof(unsigned);
+      cq_ring_size = p.cq_off.cqes + p.cq_entries * sizeof(io_uring_cqe);
+      sq_ring = mmap(0, sq_ring_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_SQ_RING);
+      cq_ring = mmap(0, cq_ring_size, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, ring, IORING_OFF_CQ_RING);
+      void * s = mmap(0, p.sq_entries * sizeof(io_uring_sqe),
+        PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring,
+        IORING_OFF_SQES);
+      if(sq_ring == MAP_FAILED || cq_ring == MAP_FAILED || s == MAP_FAILED)
+      {
+        unmap(sq_ring, sq_ring_size);
+        unmap(cq_ring, cq_ring_size);
+        unmap(s, p.sq_entries * sizeof(io_uring_sqe));
+        close(ring);
+        return;
+      }
+      char * sq = (char*) sq_ring;
+      char * cq = (char*) cq_ring;
+      sq_head = (unsigned*)(sq + p.sq_off.head);
+      sq_tail = (unsigned*)(sq + p.sq_off.tail);
+      sq_mask = (unsigned*)(sq + p.sq_off.ring_mask);
+      sq_array = (unsigned*)(sq + p.sq_off.array);
+      sq_entries = p.sq_entries;
+      sqes = (io_uring_sqe*) s;
+      cq_head = (unsigned*)(cq + p.cq_off.head);
+      cq_tail = (unsigned*)(cq + p.cq_off.tail);
+      cq_mask = (unsigned*)(cq + p.cq_off.ring_mask);
+      cqes = (io_uring_cqe*)(cq + p.cq_off.cqes);
+      fd = ring;
+    }
+
+    static void unmap(void * p, std::size_t bytes)
+    {
+      if(p != MAP_FAILED)
+      {
+        munmap(p, bytes);
+      }
+    }
+
+    /**
+     * queue one transfer and hand it to the kernel
+     */
+    void submit(int op, int file, void * buf, unsigned bytes, uint64_t offset,
+      int tag)
+    {
+      while(inflight >= sq_entries || free_count == 0)
+      {                                          // keep the cq from overflowing
+        reap(true);
+      }
+      int id = free_requests[--free_count];
+      request & r = requests[id];
+      r.op = op;
+      r.file = file;
+      r.buf = (char*) buf;
+      r.bytes = bytes;
+      r.offset = offset;
+      r.tag = tag;
+      pending[tag]++;
+      inflight++;
+      queue(id);
+    }
+
+    /**
+     * hand request id to the kernel, again for the rest of a short transfer
+     */
+    void queue(int id)
+    {
+      const request & r = requests[id];
+      if(*sq_tail - *sq_head >= sq_entries)      // the kernel holds every entry
+      {
+        flush();
+      }
+      unsigned tail = *sq_tail;
+      unsigned index = tail & *sq_mask;
+      io_uring_sqe * sqe = &sqes[index];
+      memset(sqe, 0, sizeof(*sqe));
+      sqe->opcode = r.op;
+      sqe->fd = r.file;
+      sqe->addr = (uintptr_t) r.buf;
+      sqe->len = r.bytes;
+      sqe->off = r.offset;
+      sqe->user_data = id;
+      sq_array[index] = index;
+      __sync_synchronize();                    // sqe is visible before the tail
+      *sq_tail = tail + 1;
+      flush();
+    }
+
+    /**
+     * submit all queued entries; while the kernel is busy the completions
+     * are reaped to make room, any other error fails the entries it did not
+     * take
+     */
+    void flush()
+    {
+      while(true)
+      {
+        __sync_synchronize();
+        unsigned head = *sq_head;
+        unsigned tail = *sq_tail;
+        if(head == tail)
+        {
+          return;
+        }
+        if(syscall(__NR_io_uring_enter, fd, tail - head, 0, 0, 0, 0) >= 0 ||
+           errno == EINTR)
+        {
+          continue;
+        }
+        if(errno == EBUSY || errno == EAGAIN)
+        {
+          reap(false);
+          continue;
+        }
+        int error = errno;
+        *sq_tail = head;                    // take back what the kernel refused
+        for(; head != tail; head++)
+        {
+          finish((int) sqes[sq_array[head & *sq_mask]].user_data, -error);
+        }
+      }
+    }
+
+    /**
+     * collect completions, blocks for at least one if block is set; the head
+     * is read again for every completion since finish may reap as well
+     */
+    void reap(bool block)
+    {
+      if(block)
+      {
+        syscall(__NR_io_uring_enter, fd, 0, 1, IORING_ENTER_GETEVENTS, 0, 0);
+      }
+      while(true)
+      {
+        unsigned head = *cq_head;
+        __sync_synchronize();
+        if(head == *cq_tail)
+        {
+          return;
+        }
+        __sync_synchronize();                    // cqes are read after the tail
+        io_uring_cqe * cqe = &cqes[head & *cq_mask];
+        int id = (int) cqe->user_data;
+        int res = cqe->res;
+        __sync_synchronize();               // cqes are consumed before the head
+        *cq_head = head + 1;
+        finish(id, res);
+      }
+    }
+
+    /**
+     * account the completion of request id, continue it if it was short
+     */
+    void finish(int id, int res)
+    {
+      request & r = requests[id];
+      if(res == -EINTR || res == -EAGAIN)
+      {
+        queue(id);
+        return;
+      }
+      if(res == 0 && r.op == IORING_OP_WRITE && r.bytes > 0)
+      {
+        res = -EIO;                                // a write must make progress
+      }
+      done(r.tag, res);
+      if(res > 0 && (unsigned)res < r.bytes)            // short, not at the end
+      {
+        r.buf += res;
+        r.bytes -= res;
+        r.offset += res;
+        queue(id);
+        return;
+      }
+      pending[r.tag]--;
+      inflight--;
+      free_requests[free_count++] = id;
+    }
+
+#endif // REMOTEBUFF_URING
+
+    static uring *& slot()
+    {
+      static __thread uring * u = 0;
+      return u;
+    }
+
+    static pthread_once_t & key_once()
+    {
+      static pthread_once_t once = PTHREAD_ONCE_INIT;
+      return once;
+    }
+
+    static pthread_key_t & key()
+    {
+      static pthread_key_t k;
+      return k;
+    }
+
+    static void make_key()
+    {
+      pthread_key_create(&key(), &free_ring);
+    }
+
+    static void free_ring(void * u)
+    {
+      slot() = 0;
+      delete (uring*) u;
+    }
+
+  };
+
+}
+
+/**
+ * start an asynchronous read of size bytes at offset of file into ls
+ */
+inline void file_read_async_c(void * ls, int file, uint64_t offset, int size,
+  int tag)
+{
+  ext::uring::local().read(file, ls, size, offset, tag);
+}
+
+/**
+ * start an asynchronous write of size bytes of ls at offset of file
+ */
+inline void file_write_async_c(int file, uint64_t offset, const void * ls,
+  int size, int tag)
+{
+  ext::uring::local().write(file, ls, size, offset, tag);
+}
+
+/**
+ * wait until all file transfers of this thread under tag are finished,
+ * returns the bytes transferred or -errno
+ */
+inline int64_t file_synchronize_c(int tag)
+{
+  return ext::uring::local().wait(tag);
+}
+
+#endif // __SPU__
+
+#endif // URING_HPP_INCLUDED
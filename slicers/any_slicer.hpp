@@ -0,0 +1,30 @@
+#ifndef ANY_SLICER_HPP_INCLUDED
+#define ANY_SLICER_HPP_INCLUDED
+
+#include <stdint.h>
+#include <boost/function.hpp>
+
+/**
+ * slicers
+ *
+ * a slicer is a function object that returns the element offset of block n,
+ * a negative offset means there is no block n:
+ *
+ *   int32_t operator()(uint32_t n) const
+ *
+ * the block iterators take the slicer type as template parameter so calls to
+ * slicers like vector_slicer are inlined; any_slicer is the type erased
+ * fallback for access patterns that are chosen at runtime
+ *
+ */
+
+typedef boost::function<int32_t (uint32_t n)> any_slicer;
+
+/**
+ * files outgrow 2^31 elements, the file block iterators take slicers that
+ * return int64_t offsets and any_file_slicer as their fallback
+ */
+typedef boost::function<int64_t (uint32_t n)> any_file_slicer;
+
+
+#endif // ANY_SLICER_HPP_INCLUDED
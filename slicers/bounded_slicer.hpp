@@ -0,0 +1,58 @@
+#ifndef BOUNDED_SLICER_HPP_INCLUDED
+#define BOUNDED_SLICER_HPP_INCLUDED
+
+#include <cstddef>
+#include <stdint.h>
+
+/**
+ * bounded slicer
+ *
+ * limits another slicer to its first count blocks, so the iterators stop
+ * prefetching at the end of the data instead of reading past it
+ *
+ */
+template<typename Slicer>
+struct bounded_slicer
+{
+  Slicer slicer;
+  uint32_t count;
+
+  bounded_slicer(const Slicer & slicer_, uint32_t count_) :
+    slicer(slicer_), count(count_)
+  { }
+
+  int32_t operator()(uint32_t iteration) const
+  {
+    return (iteration < count) ? slicer(iteration) : -1;
+  }
+};
+
+/**
+ * number of whole blocks of size elements a linear slicer yields inside
+ * the first length elements
+ */
+template<typename Slicer>
+inline uint32_t block_count(const Slicer & slicer, std::size_t length,
+  int size)
+{
+  int64_t first = slicer(0);
+  int64_t step = slicer(1) - first;
+  if(first < 0 || first + size > (int64_t)length)
+  {
+    return 0;
+  }
+  return (step > 0) ? (length - first - size) / step + 1 : 1;
+}
+
+/**
+ * number of blocks of size elements a linear slicer yields that start
+ * inside the first length elements, the last one may be partial
+ */
+template<typename Slicer>
+inline uint32_t partial_block_count(const Slicer & slicer, std::size_t length,
+  int size)
+{
+  return block_count(slicer, length + size - 1, size);
+}
+
+#endif // BOUNDED_SLICER_HPP_INCLUDED
@@ -0,0 +1,107 @@
+#ifndef DYNAMIC_SLICER_HPP_INCLUDED
+#define DYNAMIC_SLICER_HPP_INCLUDED
+
+#include <assert.h>
+#include <stdint.h>
+#include <vector>
+#include <boost/shared_ptr.hpp>
+
+#ifndef REMOTEBUFF_CLAIM_HISTORY
+  #define REMOTEBUFF_CLAIM_HISTORY 64           //!< least claims remembered
+#endif
+
+/**
+ * block counter
+ *
+ * hands out block indices to all workers of a stream, whoever is faster
+ * takes more blocks; the counter has to live in memory all workers share
+ *
+ */
+struct block_counter
+{
+  volatile uint32_t next;                      //!< next block to hand out
+  uint32_t count;                                   //!< number of blocks
+
+  block_counter(uint32_t count_) : next(0), count(count_) { }
+
+  /**
+   * claim the next block, returns count if all blocks are taken
+   */
+  uint32_t claim()
+  {
+    if(next >= count)                      // don't bump a drained counter
+    {
+      return count;
+    }
+    uint32_t block = __sync_fetch_and_add(&next, 1);
+    return (block < count) ? block : count;
+  }
+
+  void reset()
+  {
+    next = 0;
+  }
+};
+
+/**
+ * dynamic slicer
+ *
+ * slicer that claims the block for iteration n from a shared block counter
+ * the first time n is asked for; the block iterators ask when they prefetch,
+ * so the prefetch window stays full while blocks are assigned at runtime
+ *
+ * copies of a dynamic slicer share their claims, so an input and an output
+ * iterator built from the same slicer see the same blocks; every worker
+ * needs its own slicer
+ *
+ * the claims of the last 2*depth iterations are remembered (at least
+ * REMOTEBUFF_CLAIM_HISTORY), depth being the largest depth of the iterators
+ * that use the slicer; asking for an older claim is asserted
+ *
+ */
+struct dynamic_slicer
+{
+  struct claims
+  {
+    block_counter * counter;
+    uint32_t claimed;                     //!< number of iterations claimed
+    std::vector<int32_t> history;               //!< offsets of recent claims
+  };
+
+  boost::shared_ptr<claims> log;
+  int size;                                       //!< elements per block
+
+  dynamic_slicer(block_counter & counter_, int size_, int depth = 0) :
+    log(new claims()), size(size_)
+  {
+    log->counter = &counter_;
+    log->claimed = 0;
+    log->history.resize(2*depth > REMOTEBUFF_CLAIM_HISTORY ?
+      2*depth : REMOTEBUFF_CLAIM_HISTORY);
+  }
+
+  int32_t operator()(uint32_t iteration) const
+  {
+    claims & c = *log;
+    uint32_t length = c.history.size();
+    if(iteration < c.claimed)                         // claimed already
+    {
+      assert(c.claimed - iteration <= length);   // forgotten, history too short
+      return c.history[iteration % length];
+    }
+    if(iteration - c.claimed >= length)
+    {
+      return -1;           // far ahead, iterators compute n-depth unsigned
+    }
+    while(c.claimed <= iteration)
+    {
+      uint32_t block = c.counter->claim();
+      c.history[c.claimed % length] =
+        (block < c.counter->count) ? (int32_t)(block * size) : -1;
+      c.claimed++;
+    }
+    return c.history[iteration % length];
+  }
+};
+
+#endif // DYNAMIC_SLICER_HPP_INCLUDED
@@ -0,0 +1,55 @@
+#ifndef INDEXED_SLICER_HPP_INCLUDED
+#define INDEXED_SLICER_HPP_INCLUDED
+
+#include <stdint.h>
+#include <slicers/list_slicer.hpp>
+
+/**
+ * indexed slicer
+ *
+ * list slicer that gathers the records named by an index array, block n
+ * covers the indices n*records to (n+1)*records-1; runs of consecutive
+ * indices are merged into one segment
+ *
+ */
+struct indexed_slicer
+{
+  const int32_t * index;            //!< record indices, stays owned by caller
+  int count;                                   //!< number of indices
+  int length;                                   //!< elements in one record
+  int records;                                      //!< records per block
+  int max_segments;
+
+  indexed_slicer(const int32_t * index_, int count_, int length_,
+    int records_) :
+    index(index_), count(count_), length(length_), records(records_),
+    max_segments(records_)
+  { }
+
+  int operator()(uint32_t iteration, segment * list) const
+  {
+    int first = iteration * records;
+    if(iteration >= (uint32_t)count || first >= count)
+    {
+      return -1;
+    }
+    int last = (first + records > count) ? count : first + records;
+    int segments = 0;
+    for(int i=first; i<last; i++)
+    {
+      int32_t offset = index[i] * length;
+      if(segments > 0 && list[segments-1].offset +
+         list[segments-1].length == offset)
+      {
+        list[segments-1].length += length;         // extend the previous run
+        continue;
+      }
+      list[segments].offset = offset;
+      list[segments].length = length;
+      segments++;
+    }
+    return segments;
+  }
+};
+
+#endif // INDEXED_SLICER_HPP_INCLUDED
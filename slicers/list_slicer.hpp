@@ -0,0 +1,30 @@
+#ifndef LIST_SLICER_HPP_INCLUDED
+#define LIST_SLICER_HPP_INCLUDED
+
+#include <stdint.h>
+
+/**
+ * list slicers
+ *
+ * a list slicer describes every block as a list of contiguous runs, it fills
+ * at most max_segments segments for block n and returns how many it filled,
+ * or a negative number if there is no block n:
+ *
+ *   int max_segments;
+ *   int operator()(uint32_t n, segment * list) const
+ *
+ * the gather and scatter iterators move all runs of a block as one batch
+ *
+ */
+
+/**
+ * one contiguous run of elements of a block
+ */
+struct segment
+{
+  int32_t offset;                                  //!< offset in elements
+  int32_t length;                                  //!< length in elements
+};
+
+
+#endif // LIST_SLICER_HPP_INCLUDED
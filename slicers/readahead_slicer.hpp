@@ -0,0 +1,64 @@
+#ifndef READAHEAD_SLICER_HPP_INCLUDED
+#define READAHEAD_SLICER_HPP_INCLUDED
+
+#include <stdint.h>
+#include <containers/mapped.hpp>
+
+/**
+ * read ahead slicer
+ *
+ * wraps the slicer of an iterator over a mapped file; when the iterator asks
+ * for block n (which it does when it starts the transfer of block n) the
+ * pages of block n+ahead are requested from the kernel, so the disk reads
+ * run ahead of the prefetch window instead of faulting inside it:
+ *
+ *   readahead_slicer<vector_slicer, float> s(vector_slicer(size), file,
+ *     size, depth);
+ *   remote_block_input_iterator<float, readahead_slicer<vector_slicer,
+ *     float> > it(depth, size, s);
+ *
+ */
+template<typename Slicer, typename T>
+struct readahead_slicer
+{
+  Slicer slicer;
+  const mapped::vector<T> * file;
+  int size;                                        //!< elements per block
+  int ahead;                         //!< blocks between prefetch and hint
+  mutable uint32_t hinted;             //!< first iteration not hinted yet
+
+  readahead_slicer(const Slicer & slicer_, const mapped::vector<T> & file_,
+    int size_, int ahead_) :
+    slicer(slicer_), file(&file_), size(size_), ahead(ahead_), hinted(0)
+  { }
+
+  int32_t operator()(uint32_t iteration) const
+  {
+    if(iteration == hinted)               // iterators look back, hint once
+    {
+      if(iteration == 0)                      // the first window at once
+      {
+        for(int k=0; k<ahead; k++)
+        {
+          hint(k);
+        }
+      }
+      hint(iteration + ahead);
+      hinted++;
+    }
+    return slicer(iteration);
+  }
+
+private:
+
+  void hint(uint32_t iteration) const
+  {
+    int32_t offset = slicer(iteration);
+    if(offset >= 0)
+    {
+      file->willneed(offset, size);
+    }
+  }
+};
+
+#endif // READAHEAD_SLICER_HPP_INCLUDED
@@ -0,0 +1,45 @@
+#ifndef STRIDED_SLICER_HPP_INCLUDED
+#define STRIDED_SLICER_HPP_INCLUDED
+
+#include <stdint.h>
+#include <slicers/list_slicer.hpp>
+
+/**
+ * strided slicer
+ *
+ * list slicer for records of length elements that start every stride
+ * elements (a matrix column, every k-th record), block n gathers the records
+ * n*records to (n+1)*records-1 of the whole stream
+ *
+ */
+struct strided_slicer
+{
+  int length;                                   //!< elements in one record
+  int stride;                      //!< elements from one record to the next
+  int records;                                      //!< records per block
+  int total;                                  //!< records in the whole stream
+  int max_segments;
+
+  strided_slicer(int length_, int stride_, int records_, int total_) :
+    length(length_), stride(stride_), records(records_), total(total_),
+    max_segments(records_)
+  { }
+
+  int operator()(uint32_t iteration, segment * list) const
+  {
+    int first = iteration * records;
+    if(iteration >= (uint32_t)total || first >= total)
+    {
+      return -1;
+    }
+    int count = (first + records > total) ? total - first : records;
+    for(int i=0; i<count; i++)
+    {
+      list[i].offset = (first + i) * stride;
+      list[i].length = length;
+    }
+    return count;
+  }
+};
+
+#endif // STRIDED_SLICER_HPP_INCLUDED
@@ -0,0 +1,78 @@
+#ifndef TILE_SLICER_HPP_INCLUDED
+#define TILE_SLICER_HPP_INCLUDED
+
+#include <stdint.h>
+#include <runtime/workers.hpp>
+
+/**
+ * geometry of one tile of an image
+ */
+struct tile
+{
+  int32_t offset;                 //!< element offset of the upper left corner
+  int x;                                           //!< column of the corner
+  int y;                                              //!< row of the corner
+  int width;                         //!< columns, smaller for the right edge
+  int height;                            //!< rows, smaller for the bottom edge
+};
+
+/**
+ * tile slicer
+ *
+ * walks a row major image of dimX x dimY elements in tiles of tileX x tileY,
+ * tiles are numbered row by row and distributed round robin over the ranks
+ * like vector_slicer does with blocks; tiles at the right and bottom edge
+ * are clipped to the image
+ *
+ */
+struct tile_slicer
+{
+  int dimX;                                    //!< row stride of the image
+  int dimY;
+  int tileX;
+  int tileY;
+  int tilesX;                                     //!< tiles in one tile row
+  int count;                                       //!< total number of tiles
+  int rank;
+  int ranks;
+
+  tile_slicer(int dimX_, int dimY_, int tileX_, int tileY_) :
+    dimX(dimX_), dimY(dimY_), tileX(tileX_), tileY(tileY_),
+    tilesX((dimX_ + tileX_ - 1) / tileX_),
+    count(tilesX * ((dimY_ + tileY_ - 1) / tileY_)),
+    rank(SPE_Rank()), ranks(SPE_Size())
+  { }
+
+  /**
+   * element offset of tile n of this rank, negative if there is no such tile
+   */
+  int32_t operator()(uint32_t iteration) const
+  {
+    tile t;
+    return get(iteration, t) ? t.offset : -1;
+  }
+
+  /**
+   * geometry of tile n of this rank, returns false if there is no such tile
+   */
+  bool get(uint32_t iteration, tile & t) const
+  {
+    if(iteration >= (uint32_t)count)
+    {
+      return false;
+    }
+    uint32_t index = iteration * ranks + rank;
+    if(index >= (uint32_t)count)
+    {
+      return false;
+    }
+    t.x = (index % tilesX) * tileX;
+    t.y = (index / tilesX) * tileY;
+    t.width = (t.x + tileX > dimX) ? dimX - t.x : tileX;
+    t.height = (t.y + tileY > dimY) ? dimY - t.y : tileY;
+    t.offset = t.y * dimX + t.x;
+    return true;
+  }
+};
+
+#endif // TILE_SLICER_HPP_INCLUDED
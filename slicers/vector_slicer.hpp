@@ -1,6 +1,10 @@
 #ifndef VECTOR_SLICER_HPP_INCLUDED
 #define VECTOR_SLICER_HPP_INCLUDED
 
+#include <cstddef>
+#include <stdint.h>
+#include <runtime/workers.hpp>
+
 struct vector_slicer
 {
   int iterationsize;
@@ -9,7 +13,7 @@ struct vector_slicer
   iterationsize(SPE_Size() * buffersize_), rankoffset(SPE_Rank() * buffersize_)
   { }
 
-  int32_t operator()(uint32_t iteration)
+  int32_t operator()(uint32_t iteration) const
   {
     return iteration * iterationsize + rankoffset;
   }